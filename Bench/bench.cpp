@@ -0,0 +1,315 @@
+// Measures the overhead of the XrBridge frame loop.
+//
+// Usage: xrbridge_bench [frames]
+//
+// Each scenario initializes its own XrBridge, renders `frames` frames (600 by default) after
+//  a warm-up and reports the time spent per frame in XrBridge and in the runtime, excluding
+//  `xrWaitFrame()` (which blocks until the next display period) and the render function
+//  itself, and the number of heap allocations per frame.
+// The benchmark fails if the steady-state frame loop allocates any memory.
+// NOTE: No headset is required: the OpenXR Loader uses the runtime pointed to by the
+//  `XR_RUNTIME_JSON` environment variable, such as the one in the `/MockRuntime/` directory.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "xrbridge.hpp"
+
+// The number of frames rendered by each scenario when not given on the command line.
+static const uint64_t DEFAULT_FRAME_COUNT = 600;
+
+// The first frames are slower, since the driver and the runtime are still warming up.
+static const uint64_t WARMUP_FRAME_COUNT = 60;
+
+static bool g_running = true;
+
+// The time spent in the render function during the current frame, excluded from the measurements.
+static std::chrono::steady_clock::duration g_render_function_time{};
+
+// Counts the heap allocations of the whole program, including the ones of the runtime.
+static std::atomic<uint64_t> g_allocation_count{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++g_allocation_count;
+
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+struct Measurement
+{
+	uint64_t frame_count = 0;
+	std::chrono::steady_clock::duration overhead{};
+	uint64_t allocation_count = 0;
+};
+
+// The average overhead of a measured frame, in microseconds.
+static double get_overhead_per_frame(const Measurement& measurement)
+{
+	return std::chrono::duration<double, std::micro>(measurement.overhead).count() / measurement.frame_count;
+}
+
+// Only clear the views, so that the render function costs as little as possible.
+static void clear_view(Fbo& fbo)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	fbo.render();
+
+	glClearColor(0.22f, 0.36f, 0.42f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	g_render_function_time += std::chrono::steady_clock::now() - start;
+}
+
+// Run the frame loop, ending the frames with `end_frame`, until `frame_count` frames have been measured.
+template <typename EndFrame>
+static bool measure(XrBridge& xrbridge, const uint64_t frame_count, const EndFrame& end_frame, Measurement& measurement)
+{
+	uint64_t warmup_frame_count = 0;
+
+	while (g_running && measurement.frame_count < frame_count)
+	{
+		glutMainLoopEvent();
+
+		if (xrbridge.is_session_running() == false)
+		{
+			if (xrbridge.wait_for_session_active(std::chrono::milliseconds{ 100 }) == false)
+			{
+				std::cerr << "[ERROR] Failed to wait for the session." << std::endl;
+				return false;
+			}
+
+			continue;
+		}
+
+		const uint64_t allocation_count_start = g_allocation_count;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (xrbridge.update() == false)
+		{
+			std::cerr << "[ERROR] Failed to update XrBridge." << std::endl;
+			return false;
+		}
+
+		std::chrono::steady_clock::duration frame_overhead = std::chrono::steady_clock::now() - start;
+
+		XrBridge::FrameToken frame = {};
+		if (xrbridge.wait_frame(frame) == false)
+		{
+			std::cerr << "[ERROR] Failed to wait for the frame." << std::endl;
+			return false;
+		}
+
+		g_render_function_time = {};
+		start = std::chrono::steady_clock::now();
+
+		if (xrbridge.begin_frame(frame) == false || end_frame(xrbridge, frame) == false)
+		{
+			std::cerr << "[ERROR] Failed to render." << std::endl;
+			return false;
+		}
+
+		frame_overhead += std::chrono::steady_clock::now() - start - g_render_function_time;
+
+		glutSwapBuffers();
+
+		// Only measure the frames that were actually rendered.
+		if (frame.should_render == false || warmup_frame_count++ < WARMUP_FRAME_COUNT)
+		{
+			continue;
+		}
+
+		measurement.overhead += frame_overhead;
+		measurement.allocation_count += g_allocation_count - allocation_count_start;
+		++measurement.frame_count;
+	}
+
+	if (measurement.frame_count == 0)
+	{
+		std::cerr << "[ERROR] No frame was rendered." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Initialize an XrBridge configured by `configure`, measure its frame loop and free it.
+// Fails if the frame loop allocates any memory once warmed up.
+template <typename Configure, typename EndFrame>
+static bool run_scenario(const char* name, const uint64_t frame_count, const Configure& configure, const EndFrame& end_frame, Measurement& measurement)
+{
+	XrBridge xrbridge;
+
+	if (xrbridge.set_stereo_mode(XrBridge::StereoMode::MULTI_PASS) == false || configure(xrbridge) == false)
+	{
+		std::cerr << "[ERROR] Failed to configure XrBridge." << std::endl;
+		return false;
+	}
+
+	if (xrbridge.init("XrBridge Bench") == false)
+	{
+		std::cerr << "[ERROR] Failed to initialize XrBridge." << std::endl;
+		return false;
+	}
+
+	const bool did_measure = measure(xrbridge, frame_count, end_frame, measurement);
+
+	if (xrbridge.free() == false)
+	{
+		std::cerr << "[ERROR] Failed to free XrBridge resources." << std::endl;
+		return false;
+	}
+
+	if (did_measure == false)
+	{
+		return false;
+	}
+
+	std::cout << "[BENCH] " << name << " | frames: " << measurement.frame_count
+		<< " | frame loop overhead: " << get_overhead_per_frame(measurement) << " us/frame"
+		<< " | allocations: " << static_cast<double>(measurement.allocation_count) / measurement.frame_count << " per frame" << std::endl;
+
+	if (measurement.allocation_count > 0)
+	{
+		std::cerr << "[ERROR] The frame loop allocated memory " << measurement.allocation_count << " times." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+	glutInitContextVersion(4, 4);
+	glutInitContextProfile(GLUT_CORE_PROFILE);
+
+	glutInit(&argc, argv);
+
+	const uint64_t frame_count = argc >= 2 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_FRAME_COUNT;
+
+	if (frame_count == 0)
+	{
+		std::cerr << "[ERROR] The number of frames must be a positive integer." << std::endl;
+		return 1;
+	}
+
+	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+	glutInitWindowSize(800, 600);
+	const int window = glutCreateWindow("XrBridge Bench");
+
+	glutDisplayFunc([] () {});
+
+	glutCloseFunc([] () {
+		g_running = false;
+	});
+
+	if (glewInit() != GLEW_OK)
+	{
+		std::cerr << "[ERROR] Failed to initialize GLEW." << std::endl;
+		return 1;
+	}
+
+	glEnable(GL_DEPTH_TEST);
+
+	// The render function is created once, outside of the frame loop, so that it does not allocate any memory.
+	const XrBridge::render_function_t render_function = [] (const XrBridge::Eye, const std::shared_ptr<Fbo>& fbo, const glm::mat4, const glm::mat4, const uint32_t, const uint32_t) {
+		clear_view(*fbo);
+	};
+
+	// The same, but receiving a `XrBridge::View`. This is not wrapped in a `std::function`, so it can be inlined by the compiler.
+	const auto view_render_function = [] (const XrBridge::View& view) {
+		clear_view(view.fbo);
+	};
+
+	const auto configure_default = [] (XrBridge&) {
+		return true;
+	};
+
+	// Call OpenXR through the trampolines of the OpenXR Loader instead of the dispatch table.
+	const auto configure_loader_dispatch = [] (XrBridge& xrbridge) {
+		return xrbridge.set_direct_dispatch(false);
+	};
+
+	// Render a full resolution inset that follows the gaze of the user (requires the XR_EXT_eye_gaze_interaction OpenXR extension).
+	const auto configure_eye_gaze_foveation = [] (XrBridge& xrbridge) {
+		return xrbridge.set_foveation(true, 0.4f, 0.5f, true);
+	};
+
+	// The inset of the left eye in the first frame, to check that the eye gaze moves it.
+	bool has_first_inset = false;
+	bool did_inset_move = false;
+	XrRect2Di first_inset = {};
+
+	Measurement function_measurement;
+	Measurement view_measurement;
+	Measurement loader_dispatch_measurement;
+	Measurement foveation_measurement;
+
+	const bool did_run =
+		run_scenario("std::function", frame_count, configure_default, [&] (XrBridge& xrbridge, XrBridge::FrameToken& frame) {
+			return xrbridge.end_frame(frame, render_function);
+		}, function_measurement) &&
+		run_scenario("XrBridge::View", frame_count, configure_default, [&] (XrBridge& xrbridge, XrBridge::FrameToken& frame) {
+			return xrbridge.end_frame(frame, view_render_function);
+		}, view_measurement) &&
+		run_scenario("loader dispatch", frame_count, configure_loader_dispatch, [&] (XrBridge& xrbridge, XrBridge::FrameToken& frame) {
+			return xrbridge.end_frame(frame, render_function);
+		}, loader_dispatch_measurement) &&
+		run_scenario("eye gaze foveation", frame_count, configure_eye_gaze_foveation, [&] (XrBridge& xrbridge, XrBridge::FrameToken& frame) {
+			if (xrbridge.end_frame(frame, render_function) == false)
+			{
+				return false;
+			}
+
+			const XrRect2Di inset = xrbridge.get_foveation_inset(XrBridge::Eye::LEFT);
+
+			if (has_first_inset == false)
+			{
+				first_inset = inset;
+				has_first_inset = true;
+			}
+
+			did_inset_move |= inset.offset.x != first_inset.offset.x || inset.offset.y != first_inset.offset.y;
+
+			return true;
+		}, foveation_measurement);
+
+	if (did_run && did_inset_move == false)
+	{
+		std::cerr << "[ERROR] The foveation inset did not follow the eye gaze." << std::endl;
+	}
+
+	if (did_run)
+	{
+		std::cout << "[BENCH] XrBridge::View saves " << get_overhead_per_frame(function_measurement) - get_overhead_per_frame(view_measurement) << " us/frame over std::function" << std::endl;
+		std::cout << "[BENCH] The dispatch table saves " << get_overhead_per_frame(loader_dispatch_measurement) - get_overhead_per_frame(function_measurement) << " us/frame over the loader" << std::endl;
+	}
+
+	glutDestroyWindow(window);
+
+	return did_run && did_inset_move ? 0 : 1;
+}
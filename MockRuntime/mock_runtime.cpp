@@ -0,0 +1,1638 @@
+// A headless OpenXR runtime, used to run and benchmark XrBridge without a headset.
+//
+// The runtime is loaded by the OpenXR Loader through the manifest pointed to by the
+//  `XR_RUNTIME_JSON` environment variable (see `mock_runtime.json`). Nothing is displayed:
+//  the swapchain images are plain OpenGL textures created in the context of the application
+//  (Mesa llvmpipe is enough), the display is simulated by pacing `xrWaitFrame()` at a fixed
+//  refresh rate, and the head and the eyes (through `XR_EXT_eye_gaze_interaction`) follow
+//  a synthetic motion.
+//
+// The calls are validated just enough to catch the mistakes of the application that a real
+//  runtime would report, such as waiting for a swapchain image that was not acquired.
+
+/* ========== CONFIGURATION ========== */
+
+// The refresh rate of the simulated display, in Hz. Overridden by the
+//  `XRBRIDGE_MOCK_REFRESH_RATE` environment variable.
+#define MOCK_RUNTIME_CONFIG_REFRESH_RATE 90
+
+// The recommended size of each view, in pixels. Overridden by the
+//  `XRBRIDGE_MOCK_VIEW_WIDTH` and `XRBRIDGE_MOCK_VIEW_HEIGHT` environment variables.
+#define MOCK_RUNTIME_CONFIG_VIEW_WIDTH  1024
+#define MOCK_RUNTIME_CONFIG_VIEW_HEIGHT 1024
+
+// The number of images of each swapchain.
+#define MOCK_RUNTIME_CONFIG_SWAPCHAIN_IMAGE_COUNT 3
+
+// The half angle of the field of view of each view, in radians.
+#define MOCK_RUNTIME_CONFIG_HALF_FOV 0.8f
+
+// The distance between the eyes, in meters.
+#define MOCK_RUNTIME_CONFIG_IPD 0.063f
+
+/* ========== CONFIGURATION ========== */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#define XR_USE_GRAPHICS_API_OPENGL
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+#include <openxr/openxr_loader_negotiation.h>
+#include <openxr/openxr_reflection.h>
+
+// Only the negotiation function is exported, everything else is retrieved through `xrGetInstanceProcAddr()`.
+#define MOCK_RUNTIME_EXPORT extern "C" __attribute__((visibility("default")))
+
+static const uint32_t VIEW_COUNT = 2;
+static const uint32_t EVENT_QUEUE_SIZE = 16;
+static const XrSystemId SYSTEM_ID = 1;
+
+struct Session;
+
+struct Instance
+{
+	bool is_opengl_enabled;
+	bool is_depth_enabled;
+	bool is_visibility_mask_enabled;
+	bool is_eye_gaze_enabled;
+
+	Session* session;
+
+	/**
+		* The paths created by `xrStringToPath()`. A path is its index in this vector plus one.
+		*/
+	std::vector<std::string> paths;
+
+	/**
+		* A ring of events. The application may poll them from a different thread.
+		*/
+	std::mutex event_mutex;
+	std::array<XrEventDataBuffer, EVENT_QUEUE_SIZE> events;
+	uint32_t first_event;
+	uint32_t event_count;
+};
+
+struct Session
+{
+	Instance* instance;
+	XrSessionState state;
+
+	/**
+		* The simulated display. `next_display_time` is when the frame waited next will
+		* be displayed, one period after `xrWaitFrame()` returns.
+		*/
+	XrDuration display_period;
+	XrTime start_time;
+	XrTime next_display_time;
+
+	bool is_frame_waited;
+	bool is_frame_begun;
+
+	bool are_action_sets_attached;
+	bool are_actions_synced;
+};
+
+struct Swapchain
+{
+	GLenum target;
+	std::vector<GLuint> images;
+
+	/**
+		* The number of images acquired, waited and released since the swapchain was created.
+		* The images are used in order, so these are enough to validate the calls.
+		*/
+	uint64_t acquire_count;
+	uint64_t wait_count;
+	uint64_t release_count;
+};
+
+struct ActionSet;
+
+struct Action
+{
+	ActionSet* action_set;
+	XrActionType type;
+	bool is_bound_to_eye_gaze;
+};
+
+struct ActionSet
+{
+	Instance* instance;
+	std::vector<Action*> actions;
+	bool is_attached;
+};
+
+struct Space
+{
+	Session* session;
+	XrReferenceSpaceType type;
+	XrPosef pose;
+
+	/**
+		* The pose action of an action space, or `nullptr` for a reference space.
+		*/
+	const Action* action;
+};
+
+template <typename Handle, typename Object>
+static Handle to_handle(Object* object)
+{
+	return (Handle)(uintptr_t)object;
+}
+
+template <typename Object, typename Handle>
+static Object* from_handle(const Handle handle)
+{
+	return (Object*)(uintptr_t)handle;
+}
+
+static uint32_t get_environment_value(const char* name, const uint32_t default_value)
+{
+	const char* value = std::getenv(name);
+	const unsigned long parsed_value = value != nullptr ? std::strtoul(value, nullptr, 10) : 0;
+
+	return parsed_value > 0 ? static_cast<uint32_t>(parsed_value) : default_value;
+}
+
+static XrTime get_current_time()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static glm::quat to_quat(const XrQuaternionf& orientation)
+{
+	return glm::quat(orientation.w, orientation.x, orientation.y, orientation.z);
+}
+
+static XrPosef to_pose(const glm::quat& orientation, const glm::vec3& position)
+{
+	return { { orientation.x, orientation.y, orientation.z, orientation.w }, { position.x, position.y, position.z } };
+}
+
+// The pose `b`, expressed relative to `a`, in the space of `a`.
+static XrPosef multiply_poses(const XrPosef& a, const XrPosef& b)
+{
+	const glm::quat orientation = to_quat(a.orientation);
+	return to_pose(orientation * to_quat(b.orientation), glm::vec3(a.position.x, a.position.y, a.position.z) + orientation * glm::vec3(b.position.x, b.position.y, b.position.z));
+}
+
+static XrPosef invert_pose(const XrPosef& pose)
+{
+	const glm::quat inverse_orientation = glm::inverse(to_quat(pose.orientation));
+	return to_pose(inverse_orientation, inverse_orientation * -glm::vec3(pose.position.x, pose.position.y, pose.position.z));
+}
+
+// The synthetic motion of the head: it looks around slowly while swaying a little.
+static XrPosef get_head_pose(const Session& session, const XrTime time)
+{
+	const float t = static_cast<float>(time - session.start_time) / 1'000'000'000.0f;
+	const float two_pi = 6.283185f;
+
+	const float yaw = 0.3f * std::sin(two_pi * t / 4.0f);
+	const float pitch = 0.1f * std::sin(two_pi * t / 3.0f);
+	const glm::quat orientation = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+	const glm::vec3 position(0.02f * std::sin(two_pi * t / 2.0f), 1.6f + 0.01f * std::sin(two_pi * t / 1.5f), 0.0f);
+
+	return to_pose(orientation, position);
+}
+
+// The synthetic motion of the eyes: the gaze sweeps an ellipse around the forward direction of the head.
+static XrPosef get_eye_gaze_pose(const Session& session, const XrTime time)
+{
+	const float t = static_cast<float>(time - session.start_time) / 1'000'000'000.0f;
+	const float two_pi = 6.283185f;
+
+	const float yaw = 0.25f * std::sin(two_pi * t / 2.5f);
+	const float pitch = 0.15f * std::cos(two_pi * t / 2.5f);
+	const glm::quat orientation = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+
+	return multiply_poses(get_head_pose(session, time), to_pose(orientation, glm::vec3(0.0f)));
+}
+
+// Whether the pose of a space is known. The only input of the simulated headset is the
+//  eye tracker, which is tracked while the session is focused.
+static bool is_space_tracked(const Space& space)
+{
+	if (space.action == nullptr)
+	{
+		return true;
+	}
+
+	return space.action->is_bound_to_eye_gaze && space.session->are_actions_synced && space.session->state == XrSessionState::XR_SESSION_STATE_FOCUSED;
+}
+
+// The pose of a space in the shared tracking space, where all of the reference spaces but VIEW have their origin.
+static XrPosef get_space_pose(const Space& space, const XrTime time)
+{
+	if (space.action != nullptr)
+	{
+		return multiply_poses(get_eye_gaze_pose(*space.session, time), space.pose);
+	}
+
+	if (space.type == XrReferenceSpaceType::XR_REFERENCE_SPACE_TYPE_VIEW)
+	{
+		return multiply_poses(get_head_pose(*space.session, time), space.pose);
+	}
+
+	return space.pose;
+}
+
+static void push_event(Instance& instance, const XrEventDataBaseHeader& event, const size_t size)
+{
+	std::lock_guard<std::mutex> lock(instance.event_mutex);
+
+	if (instance.event_count == EVENT_QUEUE_SIZE)
+	{
+		return;
+	}
+
+	XrEventDataBuffer& event_buffer = instance.events[(instance.first_event + instance.event_count) % EVENT_QUEUE_SIZE];
+	event_buffer = {};
+	std::memcpy(&event_buffer, &event, size);
+	++instance.event_count;
+}
+
+static void set_session_state(Session& session, const XrSessionState state)
+{
+	session.state = state;
+
+	XrEventDataSessionStateChanged event = {};
+	event.type = XrStructureType::XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
+	event.session = to_handle<XrSession>(&session);
+	event.state = state;
+	event.time = get_current_time();
+	push_event(*session.instance, *reinterpret_cast<const XrEventDataBaseHeader*>(&event), sizeof(event));
+}
+
+static bool is_session_running(const Session& session)
+{
+	return session.state >= XrSessionState::XR_SESSION_STATE_SYNCHRONIZED && session.state <= XrSessionState::XR_SESSION_STATE_STOPPING;
+}
+
+// Fill the output array of the two-call idiom.
+template <typename T>
+static XrResult write_array(const uint32_t capacity_input, uint32_t* count_output, T* output, const T* values, const uint32_t value_count)
+{
+	if (count_output == nullptr)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	*count_output = value_count;
+
+	if (capacity_input == 0)
+	{
+		return XrResult::XR_SUCCESS;
+	}
+
+	if (capacity_input < value_count)
+	{
+		return XrResult::XR_ERROR_SIZE_INSUFFICIENT;
+	}
+
+	std::copy(values, values + value_count, output);
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== INSTANCE ========== */
+
+static const std::array<const char*, 4> SUPPORTED_EXTENSIONS = {
+	XR_KHR_OPENGL_ENABLE_EXTENSION_NAME,
+	XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME,
+	XR_KHR_VISIBILITY_MASK_EXTENSION_NAME,
+	XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME,
+};
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEnumerateInstanceExtensionProperties(const char* layer_name, const uint32_t property_capacity_input, uint32_t* property_count_output, XrExtensionProperties* properties)
+{
+	if (layer_name != nullptr)
+	{
+		return XrResult::XR_ERROR_API_LAYER_NOT_PRESENT;
+	}
+
+	std::array<XrExtensionProperties, SUPPORTED_EXTENSIONS.size()> extension_properties = {};
+	for (size_t extension_index = 0; extension_index < SUPPORTED_EXTENSIONS.size(); ++extension_index)
+	{
+		extension_properties[extension_index].type = XrStructureType::XR_TYPE_EXTENSION_PROPERTIES;
+		std::strncpy(extension_properties[extension_index].extensionName, SUPPORTED_EXTENSIONS[extension_index], XR_MAX_EXTENSION_NAME_SIZE - 1);
+		extension_properties[extension_index].extensionVersion = 1;
+	}
+
+	return write_array(property_capacity_input, property_count_output, properties, extension_properties.data(), static_cast<uint32_t>(extension_properties.size()));
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEnumerateApiLayerProperties(const uint32_t property_capacity_input, uint32_t* property_count_output, XrApiLayerProperties* properties)
+{
+	return write_array<XrApiLayerProperties>(property_capacity_input, property_count_output, properties, nullptr, 0);
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateInstance(const XrInstanceCreateInfo* create_info, XrInstance* instance_handle)
+{
+	if (create_info == nullptr || instance_handle == nullptr || create_info->type != XrStructureType::XR_TYPE_INSTANCE_CREATE_INFO)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	if (XR_VERSION_MAJOR(create_info->applicationInfo.apiVersion) != 1)
+	{
+		return XrResult::XR_ERROR_API_VERSION_UNSUPPORTED;
+	}
+
+	Instance* instance = new Instance();
+
+	for (uint32_t extension_index = 0; extension_index < create_info->enabledExtensionCount; ++extension_index)
+	{
+		const char* extension_name = create_info->enabledExtensionNames[extension_index];
+
+		const auto is_supported = [extension_name] (const char* supported_extension) {
+			return std::strcmp(extension_name, supported_extension) == 0;
+		};
+
+		if (std::none_of(SUPPORTED_EXTENSIONS.begin(), SUPPORTED_EXTENSIONS.end(), is_supported))
+		{
+			delete instance;
+			return XrResult::XR_ERROR_EXTENSION_NOT_PRESENT;
+		}
+
+		instance->is_opengl_enabled |= std::strcmp(extension_name, XR_KHR_OPENGL_ENABLE_EXTENSION_NAME) == 0;
+		instance->is_depth_enabled |= std::strcmp(extension_name, XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME) == 0;
+		instance->is_visibility_mask_enabled |= std::strcmp(extension_name, XR_KHR_VISIBILITY_MASK_EXTENSION_NAME) == 0;
+		instance->is_eye_gaze_enabled |= std::strcmp(extension_name, XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME) == 0;
+	}
+
+	*instance_handle = to_handle<XrInstance>(instance);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroyInstance(XrInstance instance_handle)
+{
+	Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	delete instance;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetInstanceProperties(XrInstance instance_handle, XrInstanceProperties* instance_properties)
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	instance_properties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+	std::strncpy(instance_properties->runtimeName, "XrBridge Mock Runtime", XR_MAX_RUNTIME_NAME_SIZE - 1);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrPollEvent(XrInstance instance_handle, XrEventDataBuffer* event_data)
+{
+	Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	std::lock_guard<std::mutex> lock(instance->event_mutex);
+
+	if (instance->event_count == 0)
+	{
+		return XrResult::XR_EVENT_UNAVAILABLE;
+	}
+
+	*event_data = instance->events[instance->first_event];
+	instance->first_event = (instance->first_event + 1) % EVENT_QUEUE_SIZE;
+	--instance->event_count;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrResultToString(XrInstance instance_handle, const XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE])
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	#define MOCK_RUNTIME_RESULT_CASE(name, value) case name: std::snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "%s", #name); break;
+
+	switch (value)
+	{
+	XR_LIST_ENUM_XrResult(MOCK_RUNTIME_RESULT_CASE)
+	default:
+		std::snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, XR_SUCCEEDED(value) ? "XR_UNKNOWN_SUCCESS_%d" : "XR_UNKNOWN_FAILURE_%d", static_cast<int>(value));
+		break;
+	}
+
+	#undef MOCK_RUNTIME_RESULT_CASE
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrStructureTypeToString(XrInstance instance_handle, const XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE])
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	#define MOCK_RUNTIME_STRUCTURE_TYPE_CASE(name, value) case name: std::snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "%s", #name); break;
+
+	switch (value)
+	{
+	XR_LIST_ENUM_XrStructureType(MOCK_RUNTIME_STRUCTURE_TYPE_CASE)
+	default:
+		std::snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XR_UNKNOWN_STRUCTURE_TYPE_%d", static_cast<int>(value));
+		break;
+	}
+
+	#undef MOCK_RUNTIME_STRUCTURE_TYPE_CASE
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== SYSTEM ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetSystem(XrInstance instance_handle, const XrSystemGetInfo* get_info, XrSystemId* system_id)
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (get_info->formFactor != XrFormFactor::XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY)
+	{
+		return XrResult::XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+	}
+
+	*system_id = SYSTEM_ID;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetSystemProperties(XrInstance instance_handle, const XrSystemId system_id, XrSystemProperties* properties)
+{
+	const Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (system_id != SYSTEM_ID)
+	{
+		return XrResult::XR_ERROR_SYSTEM_INVALID;
+	}
+
+	properties->systemId = SYSTEM_ID;
+	properties->vendorId = 0;
+	std::strncpy(properties->systemName, "XrBridge Mock HMD", XR_MAX_SYSTEM_NAME_SIZE - 1);
+	properties->graphicsProperties.maxSwapchainImageWidth = 4096;
+	properties->graphicsProperties.maxSwapchainImageHeight = 4096;
+	properties->graphicsProperties.maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED;
+	properties->trackingProperties.orientationTracking = XR_TRUE;
+	properties->trackingProperties.positionTracking = XR_TRUE;
+
+	for (XrBaseOutStructure* next = static_cast<XrBaseOutStructure*>(properties->next); next != nullptr; next = next->next)
+	{
+		if (next->type == XrStructureType::XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT && instance->is_eye_gaze_enabled)
+		{
+			reinterpret_cast<XrSystemEyeGazeInteractionPropertiesEXT*>(next)->supportsEyeGazeInteraction = XR_TRUE;
+		}
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetOpenGLGraphicsRequirementsKHR(XrInstance instance_handle, const XrSystemId system_id, XrGraphicsRequirementsOpenGLKHR* graphics_requirements)
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (system_id != SYSTEM_ID)
+	{
+		return XrResult::XR_ERROR_SYSTEM_INVALID;
+	}
+
+	graphics_requirements->minApiVersionSupported = XR_MAKE_VERSION(3, 3, 0);
+	graphics_requirements->maxApiVersionSupported = XR_MAKE_VERSION(4, 6, 0);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEnumerateViewConfigurationViews(XrInstance instance_handle, const XrSystemId system_id, const XrViewConfigurationType view_configuration_type, const uint32_t view_capacity_input, uint32_t* view_count_output, XrViewConfigurationView* views)
+{
+	if (instance_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (system_id != SYSTEM_ID)
+	{
+		return XrResult::XR_ERROR_SYSTEM_INVALID;
+	}
+
+	if (view_configuration_type != XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+	{
+		return XrResult::XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	const uint32_t view_width = get_environment_value("XRBRIDGE_MOCK_VIEW_WIDTH", MOCK_RUNTIME_CONFIG_VIEW_WIDTH);
+	const uint32_t view_height = get_environment_value("XRBRIDGE_MOCK_VIEW_HEIGHT", MOCK_RUNTIME_CONFIG_VIEW_HEIGHT);
+
+	std::array<XrViewConfigurationView, VIEW_COUNT> view_configuration_views = {};
+	for (XrViewConfigurationView& view_configuration_view : view_configuration_views)
+	{
+		view_configuration_view.type = XrStructureType::XR_TYPE_VIEW_CONFIGURATION_VIEW;
+		view_configuration_view.recommendedImageRectWidth = view_width;
+		view_configuration_view.maxImageRectWidth = view_width * 2;
+		view_configuration_view.recommendedImageRectHeight = view_height;
+		view_configuration_view.maxImageRectHeight = view_height * 2;
+		view_configuration_view.recommendedSwapchainSampleCount = 1;
+		view_configuration_view.maxSwapchainSampleCount = 1;
+	}
+
+	return write_array(view_capacity_input, view_count_output, views, view_configuration_views.data(), VIEW_COUNT);
+}
+
+/* ========== SESSION ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateSession(XrInstance instance_handle, const XrSessionCreateInfo* create_info, XrSession* session_handle)
+{
+	Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (create_info->systemId != SYSTEM_ID)
+	{
+		return XrResult::XR_ERROR_SYSTEM_INVALID;
+	}
+
+	// A graphics binding is required, but its content is not needed: the images are
+	//  created in the context that is current when the swapchains are created.
+	if (create_info->next == nullptr)
+	{
+		return XrResult::XR_ERROR_GRAPHICS_DEVICE_INVALID;
+	}
+
+	if (instance->session != nullptr)
+	{
+		return XrResult::XR_ERROR_LIMIT_REACHED;
+	}
+
+	Session* session = new Session();
+	session->instance = instance;
+	session->display_period = 1'000'000'000 / get_environment_value("XRBRIDGE_MOCK_REFRESH_RATE", MOCK_RUNTIME_CONFIG_REFRESH_RATE);
+	session->start_time = get_current_time();
+
+	instance->session = session;
+	*session_handle = to_handle<XrSession>(session);
+
+	// The simulated headset is always worn, so the session is ready right away.
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_IDLE);
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_READY);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroySession(XrSession session_handle)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	session->instance->session = nullptr;
+	delete session;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrBeginSession(XrSession session_handle, const XrSessionBeginInfo* begin_info)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (begin_info->primaryViewConfigurationType != XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+	{
+		return XrResult::XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	if (is_session_running(*session))
+	{
+		return XrResult::XR_ERROR_SESSION_RUNNING;
+	}
+
+	if (session->state != XrSessionState::XR_SESSION_STATE_READY)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_READY;
+	}
+
+	session->next_display_time = get_current_time() + session->display_period;
+	session->is_frame_waited = false;
+	session->is_frame_begun = false;
+
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_SYNCHRONIZED);
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_VISIBLE);
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_FOCUSED);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEndSession(XrSession session_handle)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_session_running(*session) == false)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_RUNNING;
+	}
+
+	// NOTE: A real runtime only allows this in the STOPPING state. The simulated headset
+	//  never stops the session, so the application is allowed to end it at any time.
+	set_session_state(*session, XrSessionState::XR_SESSION_STATE_IDLE);
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== FRAME ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrWaitFrame(XrSession session_handle, const XrFrameWaitInfo* frame_wait_info, XrFrameState* frame_state)
+{
+	(void)frame_wait_info;
+
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_session_running(*session) == false)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_RUNNING;
+	}
+
+	// Block until the display starts scanning out the previous frame, one period before
+	//  the frame being waited is displayed. If the application is late, the periods that
+	//  have already gone by are skipped, as a compositor would.
+	const XrTime now = get_current_time();
+	const XrTime wake_time = session->next_display_time - session->display_period;
+
+	if (now > wake_time)
+	{
+		const XrTime missed_period_count = (now - wake_time) / session->display_period;
+		session->next_display_time += missed_period_count * session->display_period;
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::nanoseconds(wake_time - now));
+	}
+
+	frame_state->predictedDisplayTime = session->next_display_time;
+	frame_state->predictedDisplayPeriod = session->display_period;
+	frame_state->shouldRender = session->state == XrSessionState::XR_SESSION_STATE_VISIBLE || session->state == XrSessionState::XR_SESSION_STATE_FOCUSED;
+
+	session->next_display_time += session->display_period;
+	session->is_frame_waited = true;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrBeginFrame(XrSession session_handle, const XrFrameBeginInfo* frame_begin_info)
+{
+	(void)frame_begin_info;
+
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_session_running(*session) == false)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_RUNNING;
+	}
+
+	if (session->is_frame_waited == false)
+	{
+		return XrResult::XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	session->is_frame_waited = false;
+
+	// Beginning a frame without ending the previous one discards the previous one.
+	const bool was_frame_begun = session->is_frame_begun;
+	session->is_frame_begun = true;
+
+	return was_frame_begun ? XrResult::XR_FRAME_DISCARDED : XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEndFrame(XrSession session_handle, const XrFrameEndInfo* frame_end_info)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_session_running(*session) == false)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_RUNNING;
+	}
+
+	if (session->is_frame_begun == false)
+	{
+		return XrResult::XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	session->is_frame_begun = false;
+
+	if (frame_end_info->environmentBlendMode != XrEnvironmentBlendMode::XR_ENVIRONMENT_BLEND_MODE_OPAQUE)
+	{
+		return XrResult::XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED;
+	}
+
+	if (frame_end_info->layerCount > XR_MIN_COMPOSITION_LAYERS_SUPPORTED)
+	{
+		return XrResult::XR_ERROR_LAYER_LIMIT_EXCEEDED;
+	}
+
+	// Every image submitted must have been released at least once.
+	for (uint32_t layer_index = 0; layer_index < frame_end_info->layerCount; ++layer_index)
+	{
+		const XrCompositionLayerBaseHeader* layer = frame_end_info->layers[layer_index];
+
+		if (layer == nullptr || layer->type != XrStructureType::XR_TYPE_COMPOSITION_LAYER_PROJECTION)
+		{
+			return XrResult::XR_ERROR_LAYER_INVALID;
+		}
+
+		const XrCompositionLayerProjection* projection_layer = reinterpret_cast<const XrCompositionLayerProjection*>(layer);
+
+		if (projection_layer->viewCount != VIEW_COUNT)
+		{
+			return XrResult::XR_ERROR_VALIDATION_FAILURE;
+		}
+
+		for (uint32_t view_index = 0; view_index < projection_layer->viewCount; ++view_index)
+		{
+			const XrCompositionLayerProjectionView& projection_view = projection_layer->views[view_index];
+			const Swapchain* swapchain = from_handle<Swapchain>(projection_view.subImage.swapchain);
+
+			if (swapchain == nullptr || swapchain->release_count == 0)
+			{
+				return XrResult::XR_ERROR_LAYER_INVALID;
+			}
+
+			if (projection_view.next != nullptr && static_cast<const XrCompositionLayerDepthInfoKHR*>(projection_view.next)->type == XrStructureType::XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR)
+			{
+				const Swapchain* depth_swapchain = from_handle<Swapchain>(static_cast<const XrCompositionLayerDepthInfoKHR*>(projection_view.next)->subImage.swapchain);
+
+				if (session->instance->is_depth_enabled == false || depth_swapchain == nullptr || depth_swapchain->release_count == 0)
+				{
+					return XrResult::XR_ERROR_LAYER_INVALID;
+				}
+			}
+		}
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrLocateViews(XrSession session_handle, const XrViewLocateInfo* view_locate_info, XrViewState* view_state, const uint32_t view_capacity_input, uint32_t* view_count_output, XrView* views)
+{
+	Session* session = from_handle<Session>(session_handle);
+	const Space* space = from_handle<Space>(view_locate_info->space);
+
+	if (session == nullptr || space == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (view_locate_info->viewConfigurationType != XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+	{
+		return XrResult::XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	const XrPosef head_pose = multiply_poses(invert_pose(get_space_pose(*space, view_locate_info->displayTime)), get_head_pose(*session, view_locate_info->displayTime));
+
+	std::array<XrView, VIEW_COUNT> located_views = {};
+	for (uint32_t view_index = 0; view_index < VIEW_COUNT; ++view_index)
+	{
+		const float eye_offset = (view_index == 0 ? -0.5f : 0.5f) * MOCK_RUNTIME_CONFIG_IPD;
+
+		located_views[view_index].type = XrStructureType::XR_TYPE_VIEW;
+		located_views[view_index].pose = multiply_poses(head_pose, to_pose(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(eye_offset, 0.0f, 0.0f)));
+		located_views[view_index].fov = { -MOCK_RUNTIME_CONFIG_HALF_FOV, MOCK_RUNTIME_CONFIG_HALF_FOV, MOCK_RUNTIME_CONFIG_HALF_FOV, -MOCK_RUNTIME_CONFIG_HALF_FOV };
+	}
+
+	view_state->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+
+	// Only the poses and the fields of view are written, so that the `next` chain of the views is kept.
+	if (view_count_output == nullptr)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	*view_count_output = VIEW_COUNT;
+
+	if (view_capacity_input == 0)
+	{
+		return XrResult::XR_SUCCESS;
+	}
+
+	if (view_capacity_input < VIEW_COUNT)
+	{
+		return XrResult::XR_ERROR_SIZE_INSUFFICIENT;
+	}
+
+	for (uint32_t view_index = 0; view_index < VIEW_COUNT; ++view_index)
+	{
+		views[view_index].pose = located_views[view_index].pose;
+		views[view_index].fov = located_views[view_index].fov;
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== SWAPCHAINS ========== */
+
+static const std::array<int64_t, 5> SUPPORTED_SWAPCHAIN_FORMATS = {
+	GL_SRGB8_ALPHA8,
+	GL_RGBA8,
+	GL_DEPTH_COMPONENT24,
+	GL_DEPTH_COMPONENT32F,
+	GL_DEPTH_COMPONENT16,
+};
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEnumerateSwapchainFormats(XrSession session_handle, const uint32_t format_capacity_input, uint32_t* format_count_output, int64_t* formats)
+{
+	if (session_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	return write_array(format_capacity_input, format_count_output, formats, SUPPORTED_SWAPCHAIN_FORMATS.data(), static_cast<uint32_t>(SUPPORTED_SWAPCHAIN_FORMATS.size()));
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateSwapchain(XrSession session_handle, const XrSwapchainCreateInfo* create_info, XrSwapchain* swapchain_handle)
+{
+	if (session_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (std::find(SUPPORTED_SWAPCHAIN_FORMATS.begin(), SUPPORTED_SWAPCHAIN_FORMATS.end(), create_info->format) == SUPPORTED_SWAPCHAIN_FORMATS.end())
+	{
+		return XrResult::XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+	}
+
+	if (create_info->width == 0 || create_info->height == 0 || create_info->faceCount != 1 || create_info->arraySize == 0 || create_info->mipCount != 1 || create_info->sampleCount != 1)
+	{
+		return XrResult::XR_ERROR_FEATURE_UNSUPPORTED;
+	}
+
+	const GLenum internal_format = static_cast<GLenum>(create_info->format);
+	const bool is_depth = internal_format == GL_DEPTH_COMPONENT24 || internal_format == GL_DEPTH_COMPONENT32F || internal_format == GL_DEPTH_COMPONENT16;
+	const GLenum format = is_depth ? GL_DEPTH_COMPONENT : GL_RGBA;
+	const GLenum type =
+		internal_format == GL_DEPTH_COMPONENT32F ? GL_FLOAT :
+		internal_format == GL_DEPTH_COMPONENT24 ? GL_UNSIGNED_INT :
+		internal_format == GL_DEPTH_COMPONENT16 ? GL_UNSIGNED_SHORT :
+		GL_UNSIGNED_BYTE;
+
+	Swapchain* swapchain = new Swapchain();
+	swapchain->target = create_info->arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	swapchain->images.resize(MOCK_RUNTIME_CONFIG_SWAPCHAIN_IMAGE_COUNT);
+
+	// The images are created in the context of the application, which must be current.
+	GLint previous_texture = 0;
+	glGetIntegerv(swapchain->target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D, &previous_texture);
+
+	glGenTextures(static_cast<GLsizei>(swapchain->images.size()), swapchain->images.data());
+	for (const GLuint image : swapchain->images)
+	{
+		glBindTexture(swapchain->target, image);
+		glTexParameteri(swapchain->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(swapchain->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(swapchain->target, GL_TEXTURE_MAX_LEVEL, 0);
+
+		if (swapchain->target == GL_TEXTURE_2D_ARRAY)
+		{
+			glTexImage3D(swapchain->target, 0, internal_format, create_info->width, create_info->height, create_info->arraySize, 0, format, type, nullptr);
+		}
+		else
+		{
+			glTexImage2D(swapchain->target, 0, internal_format, create_info->width, create_info->height, 0, format, type, nullptr);
+		}
+	}
+
+	glBindTexture(swapchain->target, static_cast<GLuint>(previous_texture));
+
+	if (glGetError() != GL_NO_ERROR)
+	{
+		glDeleteTextures(static_cast<GLsizei>(swapchain->images.size()), swapchain->images.data());
+		delete swapchain;
+		return XrResult::XR_ERROR_RUNTIME_FAILURE;
+	}
+
+	*swapchain_handle = to_handle<XrSwapchain>(swapchain);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroySwapchain(XrSwapchain swapchain_handle)
+{
+	Swapchain* swapchain = from_handle<Swapchain>(swapchain_handle);
+
+	if (swapchain == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	glDeleteTextures(static_cast<GLsizei>(swapchain->images.size()), swapchain->images.data());
+	delete swapchain;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrEnumerateSwapchainImages(XrSwapchain swapchain_handle, const uint32_t image_capacity_input, uint32_t* image_count_output, XrSwapchainImageBaseHeader* images)
+{
+	const Swapchain* swapchain = from_handle<Swapchain>(swapchain_handle);
+
+	if (swapchain == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (image_count_output == nullptr)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	const uint32_t image_count = static_cast<uint32_t>(swapchain->images.size());
+	*image_count_output = image_count;
+
+	if (image_capacity_input == 0)
+	{
+		return XrResult::XR_SUCCESS;
+	}
+
+	if (image_capacity_input < image_count)
+	{
+		return XrResult::XR_ERROR_SIZE_INSUFFICIENT;
+	}
+
+	if (images->type != XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	XrSwapchainImageOpenGLKHR* opengl_images = reinterpret_cast<XrSwapchainImageOpenGLKHR*>(images);
+	for (uint32_t image_index = 0; image_index < image_count; ++image_index)
+	{
+		opengl_images[image_index].image = swapchain->images[image_index];
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrAcquireSwapchainImage(XrSwapchain swapchain_handle, const XrSwapchainImageAcquireInfo* acquire_info, uint32_t* index)
+{
+	(void)acquire_info;
+
+	Swapchain* swapchain = from_handle<Swapchain>(swapchain_handle);
+
+	if (swapchain == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	// At least one image must be left to the compositor.
+	if (swapchain->acquire_count - swapchain->release_count >= swapchain->images.size() - 1)
+	{
+		return XrResult::XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	*index = static_cast<uint32_t>(swapchain->acquire_count % swapchain->images.size());
+	++swapchain->acquire_count;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrWaitSwapchainImage(XrSwapchain swapchain_handle, const XrSwapchainImageWaitInfo* wait_info)
+{
+	(void)wait_info;
+
+	Swapchain* swapchain = from_handle<Swapchain>(swapchain_handle);
+
+	if (swapchain == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	// Only the oldest acquired image that has not been waited yet can be waited. The
+	//  compositor never holds on to the images, so the wait always succeeds immediately.
+	if (swapchain->wait_count == swapchain->acquire_count)
+	{
+		return XrResult::XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	++swapchain->wait_count;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrReleaseSwapchainImage(XrSwapchain swapchain_handle, const XrSwapchainImageReleaseInfo* release_info)
+{
+	(void)release_info;
+
+	Swapchain* swapchain = from_handle<Swapchain>(swapchain_handle);
+
+	if (swapchain == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (swapchain->release_count == swapchain->wait_count)
+	{
+		return XrResult::XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	++swapchain->release_count;
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== SPACES ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateReferenceSpace(XrSession session_handle, const XrReferenceSpaceCreateInfo* create_info, XrSpace* space_handle)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (create_info->referenceSpaceType != XrReferenceSpaceType::XR_REFERENCE_SPACE_TYPE_VIEW &&
+		create_info->referenceSpaceType != XrReferenceSpaceType::XR_REFERENCE_SPACE_TYPE_LOCAL &&
+		create_info->referenceSpaceType != XrReferenceSpaceType::XR_REFERENCE_SPACE_TYPE_STAGE)
+	{
+		return XrResult::XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+	}
+
+	Space* space = new Space();
+	space->session = session;
+	space->type = create_info->referenceSpaceType;
+	space->pose = create_info->poseInReferenceSpace;
+
+	*space_handle = to_handle<XrSpace>(space);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroySpace(XrSpace space_handle)
+{
+	Space* space = from_handle<Space>(space_handle);
+
+	if (space == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	delete space;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrLocateSpace(XrSpace space_handle, XrSpace base_space_handle, const XrTime time, XrSpaceLocation* location)
+{
+	const Space* space = from_handle<Space>(space_handle);
+	const Space* base_space = from_handle<Space>(base_space_handle);
+
+	if (space == nullptr || base_space == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_space_tracked(*space) == false || is_space_tracked(*base_space) == false)
+	{
+		location->pose = to_pose(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.0f));
+		location->locationFlags = 0;
+		return XrResult::XR_SUCCESS;
+	}
+
+	location->pose = multiply_poses(invert_pose(get_space_pose(*base_space, time)), get_space_pose(*space, time));
+	location->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== ACTIONS ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrStringToPath(XrInstance instance_handle, const char* path_string, XrPath* path)
+{
+	Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (path_string == nullptr || path_string[0] != '/' || std::strlen(path_string) >= XR_MAX_PATH_LENGTH)
+	{
+		return XrResult::XR_ERROR_PATH_FORMAT_INVALID;
+	}
+
+	const std::vector<std::string>::const_iterator iterator = std::find(instance->paths.begin(), instance->paths.end(), path_string);
+
+	if (iterator == instance->paths.end())
+	{
+		instance->paths.emplace_back(path_string);
+		*path = instance->paths.size();
+	}
+	else
+	{
+		*path = (iterator - instance->paths.begin()) + 1;
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateActionSet(XrInstance instance_handle, const XrActionSetCreateInfo* create_info, XrActionSet* action_set_handle)
+{
+	Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (create_info->actionSetName[0] == '\0' || create_info->localizedActionSetName[0] == '\0')
+	{
+		return XrResult::XR_ERROR_NAME_INVALID;
+	}
+
+	ActionSet* action_set = new ActionSet();
+	action_set->instance = instance;
+
+	*action_set_handle = to_handle<XrActionSet>(action_set);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroyActionSet(XrActionSet action_set_handle)
+{
+	ActionSet* action_set = from_handle<ActionSet>(action_set_handle);
+
+	if (action_set == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	// The actions are destroyed along with their action set.
+	for (Action* action : action_set->actions)
+	{
+		delete action;
+	}
+
+	delete action_set;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateAction(XrActionSet action_set_handle, const XrActionCreateInfo* create_info, XrAction* action_handle)
+{
+	ActionSet* action_set = from_handle<ActionSet>(action_set_handle);
+
+	if (action_set == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (action_set->is_attached)
+	{
+		return XrResult::XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+	}
+
+	if (create_info->actionName[0] == '\0' || create_info->localizedActionName[0] == '\0')
+	{
+		return XrResult::XR_ERROR_NAME_INVALID;
+	}
+
+	Action* action = new Action();
+	action->action_set = action_set;
+	action->type = create_info->actionType;
+	action_set->actions.push_back(action);
+
+	*action_handle = to_handle<XrAction>(action);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrDestroyAction(XrAction action_handle)
+{
+	Action* action = from_handle<Action>(action_handle);
+
+	if (action == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	std::vector<Action*>& actions = action->action_set->actions;
+	actions.erase(std::find(actions.begin(), actions.end(), action));
+	delete action;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrSuggestInteractionProfileBindings(XrInstance instance_handle, const XrInteractionProfileSuggestedBinding* suggested_bindings)
+{
+	const Instance* instance = from_handle<Instance>(instance_handle);
+
+	if (instance == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (suggested_bindings->countSuggestedBindings == 0)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	const auto get_path_string = [instance] (const XrPath path) -> const char* {
+		return path > 0 && path <= instance->paths.size() ? instance->paths[path - 1].c_str() : nullptr;
+	};
+
+	const char* interaction_profile = get_path_string(suggested_bindings->interactionProfile);
+
+	if (interaction_profile == nullptr)
+	{
+		return XrResult::XR_ERROR_PATH_INVALID;
+	}
+
+	// The only input of the simulated headset is the eye tracker.
+	if (instance->is_eye_gaze_enabled == false || std::strcmp(interaction_profile, "/interaction_profiles/ext/eye_gaze_interaction") != 0)
+	{
+		return XrResult::XR_ERROR_PATH_UNSUPPORTED;
+	}
+
+	for (uint32_t binding_index = 0; binding_index < suggested_bindings->countSuggestedBindings; ++binding_index)
+	{
+		const XrActionSuggestedBinding& suggested_binding = suggested_bindings->suggestedBindings[binding_index];
+		const Action* action = from_handle<Action>(suggested_binding.action);
+		const char* binding = get_path_string(suggested_binding.binding);
+
+		if (action == nullptr)
+		{
+			return XrResult::XR_ERROR_HANDLE_INVALID;
+		}
+
+		if (binding == nullptr)
+		{
+			return XrResult::XR_ERROR_PATH_INVALID;
+		}
+
+		if (std::strcmp(binding, "/user/eyes_ext/input/gaze_ext/pose") != 0 || action->type != XrActionType::XR_ACTION_TYPE_POSE_INPUT)
+		{
+			return XrResult::XR_ERROR_PATH_UNSUPPORTED;
+		}
+
+		if (action->action_set->is_attached)
+		{
+			return XrResult::XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+		}
+	}
+
+	// Bind the actions to the eye tracker.
+	for (uint32_t binding_index = 0; binding_index < suggested_bindings->countSuggestedBindings; ++binding_index)
+	{
+		from_handle<Action>(suggested_bindings->suggestedBindings[binding_index].action)->is_bound_to_eye_gaze = true;
+	}
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrAttachSessionActionSets(XrSession session_handle, const XrSessionActionSetsAttachInfo* attach_info)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (session->are_action_sets_attached)
+	{
+		return XrResult::XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+	}
+
+	for (uint32_t action_set_index = 0; action_set_index < attach_info->countActionSets; ++action_set_index)
+	{
+		from_handle<ActionSet>(attach_info->actionSets[action_set_index])->is_attached = true;
+	}
+
+	session->are_action_sets_attached = true;
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrCreateActionSpace(XrSession session_handle, const XrActionSpaceCreateInfo* create_info, XrSpace* space_handle)
+{
+	Session* session = from_handle<Session>(session_handle);
+	const Action* action = from_handle<Action>(create_info->action);
+
+	if (session == nullptr || action == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (action->type != XrActionType::XR_ACTION_TYPE_POSE_INPUT)
+	{
+		return XrResult::XR_ERROR_ACTION_TYPE_MISMATCH;
+	}
+
+	Space* space = new Space();
+	space->session = session;
+	space->pose = create_info->poseInActionSpace;
+	space->action = action;
+
+	*space_handle = to_handle<XrSpace>(space);
+
+	return XrResult::XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrSyncActions(XrSession session_handle, const XrActionsSyncInfo* sync_info)
+{
+	Session* session = from_handle<Session>(session_handle);
+
+	if (session == nullptr)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (is_session_running(*session) == false)
+	{
+		return XrResult::XR_ERROR_SESSION_NOT_RUNNING;
+	}
+
+	for (uint32_t action_set_index = 0; action_set_index < sync_info->countActiveActionSets; ++action_set_index)
+	{
+		if (from_handle<ActionSet>(sync_info->activeActionSets[action_set_index].actionSet)->is_attached == false)
+		{
+			return XrResult::XR_ERROR_ACTIONSET_NOT_ATTACHED;
+		}
+	}
+
+	if (session->state != XrSessionState::XR_SESSION_STATE_FOCUSED)
+	{
+		return XrResult::XR_SESSION_NOT_FOCUSED;
+	}
+
+	session->are_actions_synced = true;
+
+	return XrResult::XR_SUCCESS;
+}
+
+/* ========== VISIBILITY MASK ========== */
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetVisibilityMaskKHR(XrSession session_handle, const XrViewConfigurationType view_configuration_type, const uint32_t view_index, const XrVisibilityMaskTypeKHR visibility_mask_type, XrVisibilityMaskKHR* visibility_mask)
+{
+	if (session_handle == XR_NULL_HANDLE)
+	{
+		return XrResult::XR_ERROR_HANDLE_INVALID;
+	}
+
+	if (view_configuration_type != XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+	{
+		return XrResult::XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	if (view_index >= VIEW_COUNT)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	// The lenses hide the corners of the views. The vertices are on the plane at 1 meter
+	//  in front of the eye, so the edges of the views are at the tangents of the half FOV.
+	const float edge = std::tan(MOCK_RUNTIME_CONFIG_HALF_FOV);
+	const float corner = edge * 0.4f;
+
+	const std::array<XrVector2f, 12> hidden_vertices = { {
+		{ -edge, edge }, { -edge + corner, edge }, { -edge, edge - corner },
+		{ edge, edge }, { edge, edge - corner }, { edge - corner, edge },
+		{ edge, -edge }, { edge - corner, -edge }, { edge, -edge + corner },
+		{ -edge, -edge }, { -edge, -edge + corner }, { -edge + corner, -edge },
+	} };
+
+	const std::array<XrVector2f, 8> outline_vertices = { {
+		{ -edge + corner, edge }, { edge - corner, edge }, { edge, edge - corner }, { edge, -edge + corner },
+		{ edge - corner, -edge }, { -edge + corner, -edge }, { -edge, -edge + corner }, { -edge, edge - corner },
+	} };
+
+	const XrVector2f* vertices = nullptr;
+	uint32_t vertex_count = 0;
+
+	switch (visibility_mask_type)
+	{
+	case XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR:
+		vertices = hidden_vertices.data();
+		vertex_count = static_cast<uint32_t>(hidden_vertices.size());
+		break;
+	case XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_LINE_LOOP_KHR:
+		vertices = outline_vertices.data();
+		vertex_count = static_cast<uint32_t>(outline_vertices.size());
+		break;
+	default:
+		break;
+	}
+
+	// The vertices are not shared, so the indices simply enumerate them.
+	std::array<uint32_t, 12> indices = {};
+	for (uint32_t index = 0; index < vertex_count; ++index)
+	{
+		indices[index] = index;
+	}
+
+	const XrResult vertex_result = write_array(visibility_mask->vertexCapacityInput, &visibility_mask->vertexCountOutput, visibility_mask->vertices, vertices, vertex_count);
+
+	if (XR_FAILED(vertex_result))
+	{
+		return vertex_result;
+	}
+
+	return write_array(visibility_mask->indexCapacityInput, &visibility_mask->indexCountOutput, visibility_mask->indices, indices.data(), vertex_count);
+}
+
+/* ========== DISPATCH ========== */
+
+struct Function
+{
+	const char* name;
+	PFN_xrVoidFunction function;
+
+	/**
+		* Whether the function can be retrieved without an instance.
+		*/
+	bool is_global;
+};
+
+#define MOCK_RUNTIME_FUNCTION( name ) { #name, reinterpret_cast<PFN_xrVoidFunction>(mock_##name), false }
+#define MOCK_RUNTIME_GLOBAL_FUNCTION( name ) { #name, reinterpret_cast<PFN_xrVoidFunction>(mock_##name), true }
+
+static const Function FUNCTIONS[] = {
+	MOCK_RUNTIME_GLOBAL_FUNCTION(xrEnumerateApiLayerProperties),
+	MOCK_RUNTIME_GLOBAL_FUNCTION(xrEnumerateInstanceExtensionProperties),
+	MOCK_RUNTIME_GLOBAL_FUNCTION(xrCreateInstance),
+	MOCK_RUNTIME_FUNCTION(xrAcquireSwapchainImage),
+	MOCK_RUNTIME_FUNCTION(xrAttachSessionActionSets),
+	MOCK_RUNTIME_FUNCTION(xrBeginFrame),
+	MOCK_RUNTIME_FUNCTION(xrBeginSession),
+	MOCK_RUNTIME_FUNCTION(xrCreateAction),
+	MOCK_RUNTIME_FUNCTION(xrCreateActionSet),
+	MOCK_RUNTIME_FUNCTION(xrCreateActionSpace),
+	MOCK_RUNTIME_FUNCTION(xrCreateReferenceSpace),
+	MOCK_RUNTIME_FUNCTION(xrCreateSession),
+	MOCK_RUNTIME_FUNCTION(xrCreateSwapchain),
+	MOCK_RUNTIME_FUNCTION(xrDestroyAction),
+	MOCK_RUNTIME_FUNCTION(xrDestroyActionSet),
+	MOCK_RUNTIME_FUNCTION(xrDestroyInstance),
+	MOCK_RUNTIME_FUNCTION(xrDestroySession),
+	MOCK_RUNTIME_FUNCTION(xrDestroySpace),
+	MOCK_RUNTIME_FUNCTION(xrDestroySwapchain),
+	MOCK_RUNTIME_FUNCTION(xrEndFrame),
+	MOCK_RUNTIME_FUNCTION(xrEndSession),
+	MOCK_RUNTIME_FUNCTION(xrEnumerateSwapchainFormats),
+	MOCK_RUNTIME_FUNCTION(xrEnumerateSwapchainImages),
+	MOCK_RUNTIME_FUNCTION(xrEnumerateViewConfigurationViews),
+	MOCK_RUNTIME_FUNCTION(xrGetInstanceProperties),
+	MOCK_RUNTIME_FUNCTION(xrGetOpenGLGraphicsRequirementsKHR),
+	MOCK_RUNTIME_FUNCTION(xrGetSystem),
+	MOCK_RUNTIME_FUNCTION(xrGetSystemProperties),
+	MOCK_RUNTIME_FUNCTION(xrGetVisibilityMaskKHR),
+	MOCK_RUNTIME_FUNCTION(xrLocateSpace),
+	MOCK_RUNTIME_FUNCTION(xrLocateViews),
+	MOCK_RUNTIME_FUNCTION(xrPollEvent),
+	MOCK_RUNTIME_FUNCTION(xrReleaseSwapchainImage),
+	MOCK_RUNTIME_FUNCTION(xrResultToString),
+	MOCK_RUNTIME_FUNCTION(xrStringToPath),
+	MOCK_RUNTIME_FUNCTION(xrStructureTypeToString),
+	MOCK_RUNTIME_FUNCTION(xrSuggestInteractionProfileBindings),
+	MOCK_RUNTIME_FUNCTION(xrSyncActions),
+	MOCK_RUNTIME_FUNCTION(xrWaitFrame),
+	MOCK_RUNTIME_FUNCTION(xrWaitSwapchainImage),
+};
+
+#undef MOCK_RUNTIME_FUNCTION
+#undef MOCK_RUNTIME_GLOBAL_FUNCTION
+
+static XRAPI_ATTR XrResult XRAPI_CALL mock_xrGetInstanceProcAddr(XrInstance instance_handle, const char* name, PFN_xrVoidFunction* function)
+{
+	if (name == nullptr || function == nullptr)
+	{
+		return XrResult::XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	*function = nullptr;
+
+	if (std::strcmp(name, "xrGetInstanceProcAddr") == 0)
+	{
+		*function = reinterpret_cast<PFN_xrVoidFunction>(mock_xrGetInstanceProcAddr);
+		return XrResult::XR_SUCCESS;
+	}
+
+	const Instance* instance = from_handle<Instance>(instance_handle);
+
+	for (const Function& entry : FUNCTIONS)
+	{
+		if (std::strcmp(name, entry.name) != 0)
+		{
+			continue;
+		}
+
+		if (instance == nullptr && entry.is_global == false)
+		{
+			return XrResult::XR_ERROR_HANDLE_INVALID;
+		}
+
+		// The extension functions are only available when the extension is enabled.
+		if ((std::strcmp(name, "xrGetOpenGLGraphicsRequirementsKHR") == 0 && instance->is_opengl_enabled == false) ||
+			(std::strcmp(name, "xrGetVisibilityMaskKHR") == 0 && instance->is_visibility_mask_enabled == false))
+		{
+			return XrResult::XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+		*function = entry.function;
+		return XrResult::XR_SUCCESS;
+	}
+
+	return XrResult::XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+MOCK_RUNTIME_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(const XrNegotiateLoaderInfo* loader_info, XrNegotiateRuntimeRequest* runtime_request)
+{
+	if (loader_info == nullptr || runtime_request == nullptr ||
+		loader_info->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+		runtime_request->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST)
+	{
+		return XrResult::XR_ERROR_INITIALIZATION_FAILED;
+	}
+
+	if (loader_info->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION || loader_info->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION ||
+		XR_VERSION_MAJOR(loader_info->minApiVersion) > 1 || XR_VERSION_MAJOR(loader_info->maxApiVersion) < 1)
+	{
+		return XrResult::XR_ERROR_INITIALIZATION_FAILED;
+	}
+
+	runtime_request->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+	runtime_request->runtimeApiVersion = XR_CURRENT_API_VERSION;
+	runtime_request->getInstanceProcAddr = mock_xrGetInstanceProcAddr;
+
+	return XrResult::XR_SUCCESS;
+}
@@ -9,12 +9,15 @@
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-Cube::Cube() :
+#include "xrbridge.hpp"
+
+Cube::Cube(const Variant variant) :
 	shader { 0 },
 	vao { 0 },
-	vbo { 0 }
+	vbo { 0 },
+	instance_count { variant == Variant::INSTANCED ? 2 : 1 }
 {
-	const std::string vertex_shader_source = R"(
+	const std::string single_view_vertex_shader_source = R"(
 		#version 440 core
 
 		uniform mat4 matrix;
@@ -30,6 +33,66 @@ Cube::Cube() :
 		}
 	)";
 
+	// The matrices of both eyes are provided by XrBridge in a uniform buffer.
+	const std::string multiview_vertex_shader_source = R"(
+		#version 440 core
+		#extension GL_OVR_multiview2 : require
+
+		layout(num_views = 2) in;
+
+		layout(std140, binding = )" + std::to_string(XrBridge::STEREO_MATRICES_BINDING) + R"() uniform XrBridgeStereoMatrices
+		{
+			mat4 projection_matrices[2];
+			mat4 view_matrices[2];
+			mat4 view_projection_matrices[2];
+		};
+
+		uniform mat4 matrix;
+
+		layout(location = 0) in vec3 position;
+
+		out vec3 pos;
+
+		void main(void)
+		{
+			gl_Position = view_projection_matrices[gl_ViewID_OVR] * matrix * vec4(position, 1.0f);
+			pos = position;
+		}
+	)";
+
+	// Each eye is drawn as a separate instance and sent to the viewport of that eye.
+	const std::string instanced_vertex_shader_source = R"(
+		#version 440 core
+		#extension GL_ARB_shader_viewport_layer_array : require
+
+		layout(std140, binding = )" + std::to_string(XrBridge::STEREO_MATRICES_BINDING) + R"() uniform XrBridgeStereoMatrices
+		{
+			mat4 projection_matrices[2];
+			mat4 view_matrices[2];
+			mat4 view_projection_matrices[2];
+		};
+
+		uniform mat4 matrix;
+
+		layout(location = 0) in vec3 position;
+
+		out vec3 pos;
+
+		void main(void)
+		{
+			const int eye = gl_InstanceID % 2;
+
+			gl_Position = view_projection_matrices[eye] * matrix * vec4(position, 1.0f);
+			gl_ViewportIndex = eye;
+			pos = position;
+		}
+	)";
+
+	const std::string& vertex_shader_source =
+		variant == Variant::MULTIVIEW ? multiview_vertex_shader_source :
+		variant == Variant::INSTANCED ? instanced_vertex_shader_source :
+		single_view_vertex_shader_source;
+
 	const std::string fragment_shader_source = R"(
 		#version 440 core
 
@@ -147,3 +210,16 @@ void Cube::render(const glm::mat4 matrix) const
 
 	glBindVertexArray(0);
 }
+
+void Cube::render_stereo(const glm::mat4 model_matrix) const
+{
+	glUseProgram(this->shader);
+
+	const int matrix_uniform_location = glGetUniformLocation(this->shader, "matrix");
+	glUniformMatrix4fv(matrix_uniform_location, 1, GL_FALSE, glm::value_ptr(model_matrix));
+
+	glBindVertexArray(this->vao);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 12 * 3, this->instance_count);
+
+	glBindVertexArray(0);
+}
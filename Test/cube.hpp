@@ -7,12 +7,25 @@
 class Cube
 {
 public:
-	Cube();
+	// The shader variant of the cube.
+	// SINGLE_VIEW: Renders a single view. Use `render()`.
+	// MULTIVIEW: Renders both eyes at once with GL_OVR_multiview2. Use `render_stereo()`
+	//  inside the stereo render function of XrBridge.
+	// INSTANCED: Renders both eyes at once by drawing 2 instances, one per viewport,
+	//  with GL_ARB_shader_viewport_layer_array. Use `render_stereo()` inside the stereo
+	//  render function of XrBridge.
+	enum class Variant { SINGLE_VIEW, MULTIVIEW, INSTANCED };
+
+	explicit Cube(const Variant variant = Variant::SINGLE_VIEW);
 	~Cube();
 
 	void render(const glm::mat4 matrix) const;
+
+	// Render the cube with the matrices of both eyes, read from the XrBridge stereo matrices buffer.
+	void render_stereo(const glm::mat4 model_matrix) const;
 private:
 	unsigned int shader;
 	unsigned int vao;
 	unsigned int vbo;
+	int instance_count;
 };
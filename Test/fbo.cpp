@@ -35,6 +35,7 @@ Fbo::Fbo()
 	}		
    nrOfMrts = 0;
    mrt = nullptr;
+   nrOfViewports = 0;
 	
 	// Allocate OGL data:
 	glGenFramebuffers(1, &glId);	
@@ -100,8 +101,8 @@ bool Fbo::isOk()
  * @param textureNumber a value between 0 and OvFbo::MAX_ATTACHMENTS to identify texture position
  * @param operation one of the enumerated operations of type OvFbo::BIND_*
  * @param texture pointer to a texture class
- * @param param1 free param 1, according to the operation
- * @param param2 free param 2, according to the operation
+ * @param param1 free param 1, according to the operation (color attachment number for color textures)
+ * @param param2 free param 2, according to the operation (number of views for multiview textures)
  * @return true on success, false on fail 	 
  */
 bool Fbo::bindTexture(unsigned int textureNumber, unsigned int operation, unsigned int texture, int param1, int param2)
@@ -132,6 +133,18 @@ bool Fbo::bindTexture(unsigned int textureNumber, unsigned int operation, unsign
          glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);         
 			break;				
 		
+		////////////////////////////////////
+      case BIND_COLORTEXTURE_MULTIVIEW: //
+         // Requires GL_OVR_multiview: all the layers of the array texture are rendered at once.
+         glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + param1, texture, 0, 0, param2);
+			drawBuffer[textureNumber] = param1;
+			break;
+
+		////////////////////////////////////
+      case BIND_DEPTHTEXTURE_MULTIVIEW: //
+         glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, 0, param2);
+			break;
+
 		///////////
       default: //
          std::cout << "[ERROR] Invalid operation" << std::endl;
@@ -142,9 +155,19 @@ bool Fbo::bindTexture(unsigned int textureNumber, unsigned int operation, unsign
 	this->texture[textureNumber] = texture;	
 
    // Get some texture information:
-   glBindTexture(GL_TEXTURE_2D, texture);
-   glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &sizeX);
-   glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &sizeY);
+   if (operation == BIND_COLORTEXTURE_MULTIVIEW || operation == BIND_DEPTHTEXTURE_MULTIVIEW)
+   {
+      glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &sizeX);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &sizeY);
+      sizeZ = param2;
+   }
+   else
+   {
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &sizeX);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &sizeY);
+   }
 	return updateMrtCache();
 }
 
@@ -197,6 +220,38 @@ bool Fbo::bindRenderBuffer(unsigned int renderBuffer, unsigned int operation, in
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////	 
+/** 
+ * Sets a sub-rect viewport, used instead of the whole FBO when rendering (requires GL_ARB_viewport_array).
+ * Each viewport can be selected in the shaders through gl_ViewportIndex.
+ * @param viewportNumber a value between 0 and Fbo::MAX_VIEWPORTS to identify the viewport
+ * @param x viewport left corner
+ * @param y viewport bottom corner
+ * @param sizeX viewport width
+ * @param sizeY viewport height
+ * @return true on success, false on fail 	 
+ */	
+bool Fbo::setViewport(unsigned int viewportNumber, int x, int y, int sizeX, int sizeY)
+{
+	// Safety net:
+   if (viewportNumber >= Fbo::MAX_VIEWPORTS)
+	{
+      std::cout << "[ERROR] Invalid params" << std::endl;
+		return false;
+	}
+
+   viewport[viewportNumber][0] = x;
+   viewport[viewportNumber][1] = y;
+   viewport[viewportNumber][2] = sizeX;
+   viewport[viewportNumber][3] = sizeY;
+   if ((int) viewportNumber >= nrOfViewports)
+      nrOfViewports = viewportNumber + 1;
+
+   // Done:
+   return true;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////	 
 /** 
  * Update the MRT cache. 
@@ -255,7 +310,11 @@ bool Fbo::render(void *data)
    if (nrOfMrts)
    {
       glDrawBuffers(nrOfMrts, mrt);		      
-		glViewport(0, 0, sizeX, sizeY);
+      if (nrOfViewports)
+         for (int c = 0; c < nrOfViewports; c++)
+            glViewportIndexedf(c, (float) viewport[c][0], (float) viewport[c][1], (float) viewport[c][2], (float) viewport[c][3]);
+      else
+		   glViewport(0, 0, sizeX, sizeY);
 	}			
 	
    // Done:   
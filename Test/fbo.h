@@ -40,6 +40,7 @@ public: //
 	
    // Constants:
    static const unsigned int MAX_ATTACHMENTS = 8; ///< Maximum number of available render buffers or textures per FBO	
+   static const unsigned int MAX_VIEWPORTS = 16;  ///< Maximum number of viewports per FBO (minimum guaranteed by GL_ARB_viewport_array)
 
    // Enumerations:
 	enum : unsigned int ///< Kind of operation
@@ -47,6 +48,8 @@ public: //
 		BIND_DEPTHBUFFER = 0,	
 		BIND_COLORTEXTURE,
 		BIND_DEPTHTEXTURE,						
+		BIND_COLORTEXTURE_MULTIVIEW,
+		BIND_DEPTHTEXTURE_MULTIVIEW,
 	};	
 
 	// Const/dest:	 
@@ -64,6 +67,7 @@ public: //
    bool isOk();   
 	bool bindTexture(unsigned int textureNumber, unsigned int operation, unsigned int texture, int param1 = 0, int param2 = 0);
 	bool bindRenderBuffer(unsigned int renderBuffer, unsigned int operation, int sizeX, int sizeY);
+   bool setViewport(unsigned int viewportNumber, int x, int y, int sizeX, int sizeY);
 
    // Rendering:     
    bool render(void *data = nullptr);
@@ -83,6 +87,10 @@ private: //
    unsigned int glId;                                 ///< OpenGL ID
    unsigned int glRenderBufferId[MAX_ATTACHMENTS];    ///< Render buffer IDs
 
+   // Viewports:
+   int nrOfViewports;                                 ///< Number of viewports, 0 to use the whole FBO
+   int viewport[MAX_VIEWPORTS][4];                    ///< Viewports (x, y, width, height)
+
    // MRT cache:   
    int nrOfMrts;                                      ///< Number of MRTs
    unsigned int *mrt;                                 ///< Cached list of buffers 
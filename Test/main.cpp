@@ -1,10 +1,16 @@
 // Author: Lorenzo Adam Piazza
 
+#include <chrono>
 #include <memory>
+#include <thread>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#ifndef _WIN32
+	#include <X11/Xlib.h>
+#endif
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -17,6 +23,56 @@
 
 static bool g_running = true;
 
+// The stereo rendering mode used by the demo.
+// MULTI_PASS renders each eye separately, MULTIVIEW renders both eyes at once
+//  (requires the GL_OVR_multiview2 OpenGL extension) and INSTANCED renders both eyes
+//  at once with instancing (requires the GL_ARB_shader_viewport_layer_array OpenGL extension).
+static const XrBridge::StereoMode g_stereo_mode = XrBridge::StereoMode::MULTI_PASS;
+
+// Whether to skip the pixels hidden by the lenses (requires the XR_KHR_visibility_mask OpenXR extension).
+static const bool g_use_visibility_mask = true;
+
+// Whether to periodically print the frame timing statistics.
+static const bool g_print_frame_stats = false;
+
+// Whether to lower the resolution when the GPU cannot keep up with the headset.
+static const bool g_use_resolution_scaling = false;
+
+// Whether to render the periphery of the eyes at a lower resolution (requires MULTI_PASS).
+static const bool g_use_foveation = false;
+
+// Whether the full resolution inset of the foveation follows the gaze of the user
+//  (requires the XR_EXT_eye_gaze_interaction OpenXR extension).
+static const bool g_use_eye_gaze = false;
+
+// Whether to shade fewer pixels towards the edges of the lenses.
+static const bool g_use_density_mask = false;
+
+// Whether to submit the previous frame again when the head does not move. The scene of the demo never changes.
+static const bool g_use_frame_reuse = false;
+
+// Whether to update the view matrices right before submitting the frame. The cube only reads
+//  the matrices from the uniform buffer when rendering both eyes at once (requires MULTIVIEW or INSTANCED).
+static const bool g_use_late_latching = false;
+
+// Whether to keep the GPU from falling more than a frame behind the CPU.
+static const bool g_limit_frames_in_flight = false;
+
+// Whether XrBridge renders on its own thread, while the main thread pushes the camera to it.
+static const bool g_use_render_thread = false;
+
+// Whether to start rendering each frame as late as possible, to reduce the latency.
+static const bool g_use_just_in_time_start = false;
+
+// Whether to render less when the render function is too slow, and recover when it is fast again.
+static const bool g_use_overrun_watchdog = false;
+
+// Whether XrBridge polls the OpenXR events on a background thread.
+static const bool g_use_event_thread = false;
+
+// Whether XrBridge prepares the depth buffer before calling the render function.
+static const bool g_is_depth_primed = g_use_visibility_mask || g_use_density_mask;
+
 int main(int argc, char** argv)
 {
 	// Setup some FreeGLUT stuff.
@@ -24,6 +80,14 @@ int main(int argc, char** argv)
 	glutInitContextVersion(4, 4);
 	glutInitContextProfile(GLUT_CORE_PROFILE);
 
+	// Xlib must be told that the render thread will use it.
+	#ifndef _WIN32
+		if (g_use_render_thread)
+		{
+			XInitThreads();
+		}
+	#endif
+
 	// Initialize FreeGLUT.
 	glutInit(&argc, argv);
 
@@ -54,6 +118,79 @@ int main(int argc, char** argv)
 	// Create an instance of XrBridge.
 	XrBridge xrbridge;
 
+	// Choose the stereo mode. This must be done before initializing XrBridge.
+	if (xrbridge.set_stereo_mode(g_stereo_mode) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the stereo mode." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_visibility_mask(g_use_visibility_mask) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the visibility mask." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_frame_stats(g_print_frame_stats) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the frame statistics." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_resolution_scaling(g_use_resolution_scaling) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the resolution scaling." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_foveation(g_use_foveation, 0.4f, 0.5f, g_use_eye_gaze) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the foveation." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_density_mask(g_use_density_mask) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the density mask." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_frame_reuse(g_use_frame_reuse) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the frame reuse." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_late_latching(g_use_late_latching) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the late latching." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_frames_in_flight(g_limit_frames_in_flight) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the frames in flight." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_just_in_time_start(g_use_just_in_time_start) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the just-in-time start." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_overrun_watchdog(g_use_overrun_watchdog) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the overrun watchdog." << std::endl;
+		return 1;
+	}
+
+	if (xrbridge.set_event_thread(g_use_event_thread) == false)
+	{
+		std::cerr << "[ERROR] Failed to set the event thread." << std::endl;
+		return 1;
+	}
+
 	// Initialize the XrBridge instance.
 	// The string is the name of the application that appears on SteamVR. This is not
 	//  really that important. You can put whatever.
@@ -69,14 +206,138 @@ int main(int argc, char** argv)
 	// NOTE: 1 unit = 1 meter
 	const glm::mat4 camera_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.5f));
 
+	// With the render thread, the camera is the one in the packet pushed by the main thread.
+	const auto get_camera_matrix = [&] () -> const glm::mat4& {
+		if (g_use_render_thread == false || xrbridge.get_frame_packet().data == nullptr)
+		{
+			return camera_matrix;
+		}
+
+		return *static_cast<const glm::mat4*>(xrbridge.get_frame_packet().data.get());
+	};
+
 	// Create an example cube.
-	const Cube cube;
+	const Cube cube(
+		g_stereo_mode == XrBridge::StereoMode::MULTIVIEW ? Cube::Variant::MULTIVIEW :
+		g_stereo_mode == XrBridge::StereoMode::INSTANCED ? Cube::Variant::INSTANCED :
+		Cube::Variant::SINGLE_VIEW);
+
+	// The render function accepts a user-defined function (in this case a lambda).
+	// This user-defined function will be called as many times as necessary
+	//  (probably twice, once for each eye; it could also not be called at all)
+	//  to render each view.
+	// NOTE: The function is created once, outside of the main loop, so that the
+	//  frame loop does not allocate any memory.
+	const XrBridge::render_function_t render_function = [&] (const XrBridge::Eye eye, const std::shared_ptr<Fbo>& fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height) {
+		// Bind the FBO and set the viewport. This is not done automatically
+		//  by XrBridge, so we must do it ourselves!
+		fbo->render();
+
+		// Clear the FBO. When the visibility mask or the density mask is used, XrBridge
+		//  has already prepared the depth buffer, so only the color is cleared.
+		glClearColor(0.22f, 0.36f, 0.42f, 1.0f);
+		glClear(g_is_depth_primed ? GL_COLOR_BUFFER_BIT : GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Render the example cube.
+		cube.render(
+				projection_matrix *
+				glm::inverse(view_matrix) *
+				glm::inverse(get_camera_matrix()) *
+				glm::scale(glm::mat4(1.0f), glm::vec3(0.1f)));
+
+		if (eye == XrBridge::Eye::LEFT)
+		{
+			glDisable(GL_SCISSOR_TEST);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, 800, 600, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+	};
+
+	// When rendering both eyes at once, the stereo render function is called only once per frame.
+	// The matrices of both eyes are available to the shaders through a uniform buffer.
+	const XrBridge::stereo_render_function_t stereo_render_function = [&] (const std::shared_ptr<Fbo>& fbo, const XrBridge::StereoMatrices& matrices, const GLuint matrices_buffer, const uint32_t width, const uint32_t height) {
+		fbo->render();
+
+		glClearColor(0.22f, 0.36f, 0.42f, 1.0f);
+		glClear(g_is_depth_primed ? GL_COLOR_BUFFER_BIT : GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		cube.render_stereo(
+				glm::inverse(get_camera_matrix()) *
+				glm::scale(glm::mat4(1.0f), glm::vec3(0.1f)));
+	};
+
+	if (g_use_render_thread)
+	{
+		const bool did_start = g_stereo_mode == XrBridge::StereoMode::MULTI_PASS ?
+			xrbridge.start_render_thread(render_function) :
+			xrbridge.start_render_thread_stereo(stereo_render_function);
+
+		if (did_start == false)
+		{
+			std::cerr << "[ERROR] Failed to start the render thread." << std::endl;
+			return 1;
+		}
+
+		// FreeGLUT makes the context of the window current when redrawing it, so the events of
+		//  the window are not processed while the render thread owns the context. The demo
+		//  runs until the session exits, which stops the render thread.
+		std::chrono::steady_clock::time_point next_stats_time = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			// The simulation runs at its own rate, here 100 Hz. The camera of the demo never moves.
+			if (xrbridge.push_frame_packet(std::make_shared<const glm::mat4>(camera_matrix)) == false)
+			{
+				break;
+			}
+
+			if (g_print_frame_stats && std::chrono::steady_clock::now() >= next_stats_time)
+			{
+				const XrBridge::FrameStats stats = xrbridge.get_frame_stats();
+
+				std::cout << "[STATS] Frames: " << stats.frame_count << ", missed: " << stats.missed_frame_count
+					<< " | render p50/p99: " << stats.render_function.p50 << "/" << stats.render_function.p99 << " ms"
+					<< " | packet age p50/p99: " << stats.frame_packet_age.p50 << "/" << stats.frame_packet_age.p99 << " ms"
+					<< " | queue depth: " << stats.frame_packet_queue_depth << ", dropped: " << stats.dropped_frame_packet_count << std::endl;
+
+				next_stats_time += std::chrono::seconds{ 1 };
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+		}
+
+		if (xrbridge.stop_render_thread() == false)
+		{
+			std::cerr << "[ERROR] Failed to render." << std::endl;
+			return 1;
+		}
+
+		xrbridge.free();
+		glutDestroyWindow(window);
+
+		return 0;
+	}
+
+	uint64_t frame_index = 0;
 
 	while (g_running)
 	{
 		// Process FreeGLUT events.
 		glutMainLoopEvent();
 
+		// While the headset is not in use, sleep until the session runs instead of spinning.
+		// The timeout keeps the window responsive.
+		if (xrbridge.is_session_running() == false)
+		{
+			if (xrbridge.wait_for_session_active(std::chrono::milliseconds{ 100 }) == false)
+			{
+				std::cerr << "[ERROR] Failed to wait for the session." << std::endl;
+				return 1;
+			}
+
+			continue;
+		}
+
 		// Update XrBridge. This should be called once per frame.
 		if (xrbridge.update() == false)
 		{
@@ -84,33 +345,17 @@ int main(int argc, char** argv)
 			return 1;
 		}
 
+		// The cube never moves, so the previous frame can be reused if the head does not move either.
+		if (g_use_frame_reuse && xrbridge.mark_scene_clean() == false)
+		{
+			std::cerr << "[ERROR] Failed to mark the scene as clean." << std::endl;
+			return 1;
+		}
+
 		// Render the scene.
-		// The render function accepts a user-defined function (in this case a lambda).
-		// This user-defined function will be called as many times as necessary
-		//  (probably twice, once for each eye; it could also not be called at all)
-		//  to render each view.
-		const bool did_render = xrbridge.render([&] (const XrBridge::Eye eye, std::shared_ptr<Fbo> fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height) {
-			// Bind the FBO and set the viewport. This is not done automatically
-			//  by XrBridge, so we must do it ourselves!
-			fbo->render();
-
-			// Clear the FBO.
-			glClearColor(0.22f, 0.36f, 0.42f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			// Render the example cube.
-			cube.render(
-					projection_matrix *
-					glm::inverse(view_matrix) *
-					glm::inverse(camera_matrix) *
-					glm::scale(glm::mat4(1.0f), glm::vec3(0.1f)));
-
-			if (eye == XrBridge::Eye::LEFT)
-			{
-				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-				glBlitFramebuffer(0, 0, width, height, 0, 0, 800, 600, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-			}
-		});
+		const bool did_render = g_stereo_mode == XrBridge::StereoMode::MULTI_PASS ?
+			xrbridge.render(render_function) :
+			xrbridge.render_stereo(stereo_render_function);
 
 		if (did_render == false)
 		{
@@ -118,6 +363,23 @@ int main(int argc, char** argv)
 			return 1;
 		}
 
+		// The statistics are only retrieved once in a while, since computing the percentiles is not free.
+		if (g_print_frame_stats && ++frame_index % XrBridge::FRAME_STATS_WINDOW_SIZE == 0)
+		{
+			const XrBridge::FrameStats stats = xrbridge.get_frame_stats();
+
+			std::cout << "[STATS] Frames: " << stats.frame_count << ", missed: " << stats.missed_frame_count << ", reused: " << xrbridge.get_reused_frame_count()
+				<< " | wait p50/p99: " << stats.wait_frame.p50 << "/" << stats.wait_frame.p99 << " ms"
+				<< " | render p50/p99: " << stats.render_function.p50 << "/" << stats.render_function.p99 << " ms"
+				<< " | GPU L/R p95: " << stats.gpu_time[0].p95 << "/" << stats.gpu_time[1].p95 << " ms"
+				<< " | image wait L/R p95: " << stats.eye_wait_image[0].p95 << "/" << stats.eye_wait_image[1].p95 << " ms (" << stats.wait_image_timeout_count << " timeouts)"
+				<< " | pose to submit p95: " << stats.pose_to_end_frame.p95 << " ms"
+				<< " | GPU throttle p95: " << stats.frames_in_flight_wait.p95 << " ms"
+				<< " | JIT sleep p50: " << stats.just_in_time_sleep.p50 << " ms (margin " << stats.just_in_time_margin << " ms)"
+				<< " | overruns: " << stats.overrun_count << ", degradation level: " << static_cast<int>(xrbridge.get_degradation_level())
+				<< " | depth memory saved: " << (xrbridge.get_saved_depth_memory() >> 20) << " MiB" << std::endl;
+		}
+
 		// Swap the buffers.
 		glutSwapBuffers();
 	}
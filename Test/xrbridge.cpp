@@ -14,11 +14,53 @@
 // The OpenXR version to use.
 #define XRBRIDGE_CONFIG_OPENXR_VERSION XR_MAKE_VERSION(1, 0, 0);
 
+// The fraction of the display period that the GPU can use when the resolution is scaled
+//  dynamically. The rest is left to the runtime's compositor.
+#define XRBRIDGE_CONFIG_GPU_BUDGET 0.9f
+
+// The longest time a single wait for a swapchain image may block, in nanoseconds. The wait is
+//  repeated until the image is available, and each repetition is counted in the frame statistics.
+#define XRBRIDGE_CONFIG_SWAPCHAIN_WAIT_TIMEOUT 2'000'000
+
+// How many times a wait for a swapchain image may time out before giving up, so that a stuck
+//  compositor cannot hang the application.
+#define XRBRIDGE_CONFIG_SWAPCHAIN_WAIT_MAX_TIMEOUTS 500
+
+// The longest time a single wait for the frames in flight may block, in nanoseconds, and how
+//  many times it may time out before giving up, so that a hung GPU cannot hang the frame loop.
+#define XRBRIDGE_CONFIG_FRAMES_IN_FLIGHT_WAIT_TIMEOUT      100'000'000
+#define XRBRIDGE_CONFIG_FRAMES_IN_FLIGHT_WAIT_MAX_TIMEOUTS 20
+
+// The longest time the late latching may wait for the GPU to copy the matrices of a frame, in
+//  nanoseconds, so that a hung GPU cannot hang the frame loop.
+#define XRBRIDGE_CONFIG_LATE_LATCHING_WAIT_TIMEOUT 1'000'000'000
+
+// The shortest and the longest interval between two polls for events while waiting for the
+//  session to run, in milliseconds. The interval doubles each time nothing changes.
+#define XRBRIDGE_CONFIG_IDLE_POLL_MIN_INTERVAL 1
+#define XRBRIDGE_CONFIG_IDLE_POLL_MAX_INTERVAL 100
+
+// How many consecutive frames the render function must overrun before the overrun watchdog
+//  degrades the rendering, and how many must leave enough headroom before it recovers.
+#define XRBRIDGE_CONFIG_WATCHDOG_OVERRUN_FRAMES  3
+#define XRBRIDGE_CONFIG_WATCHDOG_RECOVERY_FRAMES 90
+
+// How long the event thread sleeps when there are no events, in milliseconds.
+#define XRBRIDGE_CONFIG_EVENT_THREAD_POLL_INTERVAL 5
+
+// How often the render thread copies the frame statistics for the other threads, in frames.
+#define XRBRIDGE_CONFIG_RENDER_THREAD_STATS_INTERVAL 16
+
 /* ========== CONFIGURATION ========== */
 
 #include "xrbridge.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 #ifdef _WIN32
 	#define XRBRIDGE_PLATFORM_WINDOWS
@@ -40,6 +82,7 @@
 
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 // Choose the OpenXR platform.
 #ifdef XRBRIDGE_PLATFORM_WINDOWS
@@ -60,7 +103,15 @@
 		return false; \
 	}
 
+#define XRBRIDGE_CHECK_RENDER_THREAD() \
+	if (this->is_used_by_render_thread()) \
+	{ \
+		XRBRIDGE_ERROR_OUT("You cannot call this function while the render thread is running!"); \
+		return false; \
+	}
+
 #define XRBRIDGE_CHECK_RENDERING( value ) \
+	XRBRIDGE_CHECK_RENDER_THREAD(); \
 	if (this->is_currently_rendering_flag == value) \
 	{ \
 		XRBRIDGE_ERROR_OUT("You cannot call this function inside the render function!"); \
@@ -81,6 +132,22 @@
 		return false; \
 	}
 
+// Load an OpenXR function into the dispatch table. With the direct dispatch, the function
+//  is retrieved from the runtime, otherwise the function exported by the loader is used.
+#define XRBRIDGE_LOAD_FUNCTION( name ) \
+	if (this->is_direct_dispatch_enabled) \
+	{ \
+		RETURN_FALSE_ON_OXR_ERROR(xrGetInstanceProcAddr(this->instance, #name, reinterpret_cast<PFN_xrVoidFunction*>(&this->dispatch.name)), "Failed to get function pointer of " #name "."); \
+	} \
+	else \
+	{ \
+		this->dispatch.name = name; \
+	}
+
+// Load an OpenXR extension function into the dispatch table. These are not exported by the loader.
+#define XRBRIDGE_LOAD_EXTENSION_FUNCTION( name ) \
+	RETURN_FALSE_ON_OXR_ERROR(xrGetInstanceProcAddr(this->instance, #name, reinterpret_cast<PFN_xrVoidFunction*>(&this->dispatch.name)), "Failed to get function pointer of " #name ".");
+
 // Convert an OpenXR vector to a GLM vector.
 #define XRV_TO_GV( xrv ) glm::vec3(xrv.x, xrv.y, xrv.z)
 
@@ -109,6 +176,10 @@
 	#define XRBRIDGE_SWAPCHAIN_FORMAT XRBRIDGE_CONFIG_SWAPCHAIN_FORMAT_LINUX
 #endif
 
+// The object whose render thread is the calling thread, if any. This is set by the render thread
+//  itself, since the `std::thread` object is still being assigned when the thread starts.
+static thread_local const XrBridge* render_thread_owner = nullptr;
+
 // Source: https://openxr-tutorial.com/linux/opengl/_downloads/f4aef9ec726fccc71e105bc0830d4ff3/xr_linear_algebra.h
 // XrMatrix4x4f_CreateProjectionFov
 // XrMatrix4x4f_CreateProjection
@@ -148,6 +219,323 @@ static glm::mat4 create_projection_matrix(const XrFovf fov, const float near_cli
 	return result;
 }
 
+// The view matrix of a pose, which transforms from view space to the reference space.
+static glm::mat4 create_view_matrix(const XrPosef& pose)
+{
+	const glm::quat quaternion = glm::quat(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+	const glm::mat4 rotation_matrix = glm::mat4_cast(quaternion);
+	const glm::mat4 translation_matrix = glm::translate(glm::mat4(1.0f), XRV_TO_GV(pose.position));
+
+	return translation_matrix * rotation_matrix;
+}
+
+// The shader used to draw the visibility mask. The hidden area is drawn on the near plane, so that
+//  everything behind it fails the depth test. The `#version` directive and the defines
+//  for the stereo mode are prepended at runtime.
+static const char* VISIBILITY_MASK_VERTEX_SHADER_SOURCE = R"(
+	// X and Y on the z = -1 plane, Z is the index of the view.
+	layout(location = 0) in vec3 position;
+
+	layout(location = 0) uniform mat4 projection_matrices[2];
+
+	void main(void)
+	{
+		const int view_index = int(position.z);
+
+		gl_Position = projection_matrices[view_index] * vec4(position.xy, -1.0f, 1.0f);
+		gl_Position.z = -gl_Position.w;
+
+	#if defined(XRBRIDGE_MULTIVIEW)
+		// Only keep the triangles of the current view. The others collapse to a point.
+		if (view_index != int(gl_ViewID_OVR))
+		{
+			gl_Position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	#elif defined(XRBRIDGE_INSTANCED)
+		gl_ViewportIndex = view_index;
+	#endif
+	}
+)";
+
+static const char* VISIBILITY_MASK_FRAGMENT_SHADER_SOURCE = R"(
+	#version 440 core
+
+	void main(void)
+	{
+	}
+)";
+
+// The functions shared by the shaders of the radial density mask. The `#version` directive and the
+//  defines for the stereo mode are prepended at runtime.
+static const char* DENSITY_MASK_COMMON_SHADER_SOURCE = R"(
+	// Left, right, down and up tangents of the field of view of each view.
+	layout(location = 0) uniform vec4 fov_tangents[2];
+
+	// The region of each view in pixels: x, y, width and height.
+	layout(location = 2) uniform vec4 view_rects[2];
+
+	// The inner and outer radii.
+	layout(location = 4) uniform vec2 radii;
+
+	bool is_inside(const int view_index, const ivec2 pixel)
+	{
+		const vec4 view_rect = view_rects[view_index];
+		return all(greaterThanEqual(vec2(pixel), view_rect.xy)) && all(lessThan(vec2(pixel), view_rect.xy + view_rect.zw));
+	}
+
+	// Whether the block of 2x2 pixels containing the pixel is skipped.
+	bool is_skipped(const int view_index, const ivec2 pixel)
+	{
+		const vec4 view_rect = view_rects[view_index];
+		const vec4 tangents = fov_tangents[view_index];
+		const ivec2 block = (pixel - ivec2(view_rect.xy)) / 2;
+
+		// The center of the block, as the tangents of the angles from the center of the lens.
+		const vec2 tangent = mix(tangents.xz, tangents.yw, (vec2(block * 2) + 1.0f) / view_rect.zw);
+
+		// The edges of the field of view are at a radius of 1.
+		const vec2 extent = vec2(tangent.x > 0.0f ? tangents.y : -tangents.x, tangent.y > 0.0f ? tangents.w : -tangents.z);
+		const float radius = length(tangent / extent);
+
+		if (radius < radii.x)
+		{
+			return false;
+		}
+		else if (radius < radii.y)
+		{
+			return ((block.x + block.y) & 1) == 1;
+		}
+		else
+		{
+			return ((block.x | block.y) & 1) == 1;
+		}
+	}
+)";
+
+static const char* DENSITY_MASK_VERTEX_SHADER_SOURCE = R"(
+	flat out int view_index;
+
+	void main(void)
+	{
+	#if defined(XRBRIDGE_MULTIVIEW)
+		view_index = int(gl_ViewID_OVR);
+	#elif defined(XRBRIDGE_INSTANCED)
+		view_index = gl_InstanceID;
+		gl_ViewportIndex = gl_InstanceID;
+	#else
+		view_index = 0;
+	#endif
+
+		// A triangle covering the whole viewport, on the near plane.
+		const vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+		gl_Position = vec4(position * 2.0f - 1.0f, -1.0f, 1.0f);
+	}
+)";
+
+static const char* DENSITY_MASK_FRAGMENT_SHADER_SOURCE = R"(
+	flat in int view_index;
+
+	void main(void)
+	{
+		if (is_skipped(view_index, ivec2(gl_FragCoord.xy)) == false)
+		{
+			discard;
+		}
+	}
+)";
+
+static const char* DENSITY_MASK_RECONSTRUCTION_FRAGMENT_SHADER_SOURCE = R"(
+	flat in int view_index;
+
+	#if defined(XRBRIDGE_MULTIVIEW)
+		layout(binding = 0) uniform sampler2DArray scene;
+		#define FETCH(pixel) texelFetch(scene, ivec3(pixel, view_index), 0)
+	#else
+		layout(binding = 0) uniform sampler2D scene;
+		#define FETCH(pixel) texelFetch(scene, pixel, 0)
+	#endif
+
+	layout(location = 0) out vec4 color;
+
+	void main(void)
+	{
+		const ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+		if (is_skipped(view_index, pixel) == false)
+		{
+			discard;
+		}
+
+		// Average the same pixel of the surrounding blocks that were shaded.
+		vec4 sum = vec4(0.0f);
+		float count = 0.0f;
+
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int x = -1; x <= 1; ++x)
+			{
+				const ivec2 neighbor = pixel + ivec2(x, y) * 2;
+
+				if (is_inside(view_index, neighbor) && is_skipped(view_index, neighbor) == false)
+				{
+					sum += FETCH(neighbor);
+					count += 1.0f;
+				}
+			}
+		}
+
+		color = count > 0.0f ? sum / count : FETCH(pixel);
+	}
+)";
+
+// Copies the published slot of the late latching staging buffer to the matrices buffer, and
+//  records which slot has been copied. The index is read by a single invocation, so that every
+//  matrix comes from the same slot.
+static const char* LATE_LATCHING_COPY_SHADER_SOURCE = R"(
+	layout(local_size_x = 24) in;
+
+	layout(std430, binding = 0) readonly buffer Staging
+	{
+		uint published_slot;
+		vec4 slots[];
+	};
+
+	layout(std430, binding = 1) writeonly buffer Matrices
+	{
+		vec4 matrices[];
+	};
+
+	layout(std430, binding = 2) writeonly buffer CopiedSlot
+	{
+		uint copied_slot;
+	};
+
+	shared uint slot;
+
+	void main(void)
+	{
+		if (gl_LocalInvocationIndex == 0)
+		{
+			slot = published_slot;
+			copied_slot = slot;
+		}
+
+		barrier();
+
+		matrices[gl_LocalInvocationIndex] = slots[slot * gl_WorkGroupSize.x + gl_LocalInvocationIndex];
+	}
+)";
+
+static bool check_shader(const GLuint shader)
+{
+	GLint success = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+	if (success == GL_FALSE)
+	{
+		char log[1024] = {};
+		glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		XRBRIDGE_ERROR_OUT("Failed to compile shader: " << log);
+		return false;
+	}
+
+	return true;
+}
+
+static GLuint create_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source)
+{
+	const char* vertex_source = vertex_shader_source.c_str();
+	const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex_shader, 1, &vertex_source, nullptr);
+	glCompileShader(vertex_shader);
+
+	const char* fragment_source = fragment_shader_source.c_str();
+	const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment_shader, 1, &fragment_source, nullptr);
+	glCompileShader(fragment_shader);
+
+	GLuint program = 0;
+
+	if (check_shader(vertex_shader) && check_shader(fragment_shader))
+	{
+		program = glCreateProgram();
+		glAttachShader(program, vertex_shader);
+		glAttachShader(program, fragment_shader);
+		glLinkProgram(program);
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (success == GL_FALSE)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to link shader program.");
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	return program;
+}
+
+static GLuint create_compute_program(const std::string& compute_shader_source)
+{
+	const char* compute_source = compute_shader_source.c_str();
+	const GLuint compute_shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(compute_shader, 1, &compute_source, nullptr);
+	glCompileShader(compute_shader);
+
+	GLuint program = 0;
+
+	if (check_shader(compute_shader))
+	{
+		program = glCreateProgram();
+		glAttachShader(program, compute_shader);
+		glLinkProgram(program);
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (success == GL_FALSE)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to link shader program.");
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	glDeleteShader(compute_shader);
+
+	return program;
+}
+
+static float get_elapsed_milliseconds(const std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static GLenum get_depth_format_internal_format(const XrBridge::DepthFormat depth_format)
+{
+	switch (depth_format)
+	{
+	case XrBridge::DepthFormat::D16:
+		return GL_DEPTH_COMPONENT16;
+	case XrBridge::DepthFormat::D32F:
+		return GL_DEPTH_COMPONENT32F;
+	case XrBridge::DepthFormat::D24:
+	default:
+		return GL_DEPTH_COMPONENT24;
+	}
+}
+
+// The size in bytes of a single pixel. 24 bit depth is usually padded to 32 bits.
+static uint64_t get_depth_format_size(const XrBridge::DepthFormat depth_format)
+{
+	return depth_format == XrBridge::DepthFormat::D16 ? 2 : 4;
+}
+
 static bool check_openxr_result(const XrInstance instance, const XrResult result)
 {
 	if (result != XrResult::XR_SUCCESS)
@@ -226,13 +614,69 @@ XrBridge::XrBridge() :
 	is_already_deinitialized_flag{ false },
 	near_clipping_plane{ 0.1f },
 	far_clipping_plane{ 65'536.0f },
+	stereo_mode{ StereoMode::MULTI_PASS },
+	depth_format{ DepthFormat::D24 },
+	saved_depth_memory{ 0 },
+	is_depth_submission_enabled{ false },
+	is_visibility_mask_enabled{ false },
+	visibility_masks{ },
+	visibility_mask_shader{ 0 },
+	visibility_mask_vao{ 0 },
+	visibility_mask_vbo{ 0 },
+	is_frame_stats_enabled{ false },
+	frame_stats{ },
+	is_resolution_scaling_enabled{ false },
+	resolution_scaling{ },
+	is_foveation_enabled{ false },
+	foveation{ },
+	is_density_mask_enabled{ false },
+	density_mask{ },
+	is_frame_reuse_enabled{ false },
+	frame_reuse{ },
+	is_late_latching_enabled{ false },
+	late_latching{ },
+	is_frames_in_flight_enabled{ false },
+	frames_in_flight{ },
+	is_just_in_time_enabled{ false },
+	just_in_time{ },
+	is_watchdog_enabled{ false },
+	watchdog{ },
+	is_slack_tasks_enabled{ false },
+	slack_reserve{ 2.0f },
+	slack_tasks{ },
+	is_direct_dispatch_enabled{ true },
+	dispatch{ },
+	is_render_thread_enabled{ false },
+	render_thread{ },
+	is_event_thread_enabled{ false },
+	event_thread{ },
+	pre_pass_function{ nullptr },
+	stereo_matrices_buffer{ 0 },
 	instance{ XR_NULL_HANDLE },
 	system_id{ XR_NULL_SYSTEM_ID },
 	session{ XR_NULL_HANDLE },
 	session_state{ XrSessionState::XR_SESSION_STATE_UNKNOWN },
+	is_session_running_flag{ false },
 	swapchains{ },
-	space{ XR_NULL_HANDLE }
+	space{ XR_NULL_HANDLE },
+	frame_state{ }
+{
+}
+
+XrBridge::~XrBridge()
 {
+	// Never leave a thread running on a destroyed object, even if `free()` has not been called.
+	if (this->render_thread.thread.joinable())
+	{
+		this->render_thread.should_stop.store(true, std::memory_order_release);
+		this->render_thread.thread.join();
+	}
+
+	if (this->event_thread.thread.joinable())
+	{
+		this->event_thread.should_stop.store(true, std::memory_order_release);
+		this->event_thread.thread.join();
+	}
 }
 
 bool XrBridge::init(const std::string& application_name)
@@ -247,6 +691,54 @@ bool XrBridge::init(const std::string& application_name)
 		return false;
 	}
 
+	if (this->stereo_mode == StereoMode::MULTIVIEW && GLEW_OVR_multiview2 == GL_FALSE)
+	{
+		XRBRIDGE_ERROR_OUT("StereoMode::MULTIVIEW requires the GL_OVR_multiview2 OpenGL extension, which is not available.");
+		return false;
+	}
+
+	if (this->stereo_mode == StereoMode::INSTANCED && (GLEW_ARB_viewport_array == GL_FALSE || GLEW_ARB_shader_viewport_layer_array == GL_FALSE))
+	{
+		XRBRIDGE_ERROR_OUT("StereoMode::INSTANCED requires the GL_ARB_viewport_array and GL_ARB_shader_viewport_layer_array OpenGL extensions, which are not available.");
+		return false;
+	}
+
+	if (this->is_foveation_enabled && (this->stereo_mode != StereoMode::MULTI_PASS || this->is_resolution_scaling_enabled || this->is_visibility_mask_enabled))
+	{
+		XRBRIDGE_ERROR_OUT("Foveated rendering requires StereoMode::MULTI_PASS and cannot be used together with the resolution scaling or the visibility mask.");
+		return false;
+	}
+
+	if (this->is_density_mask_enabled && (this->is_foveation_enabled || this->is_depth_submission_enabled))
+	{
+		XRBRIDGE_ERROR_OUT("The density mask cannot be used together with foveated rendering or the depth submission.");
+		return false;
+	}
+
+	if (this->is_late_latching_enabled && (GLEW_ARB_buffer_storage == GL_FALSE || GLEW_ARB_compute_shader == GL_FALSE || GLEW_ARB_shader_storage_buffer_object == GL_FALSE))
+	{
+		XRBRIDGE_ERROR_OUT("The late latching requires the GL_ARB_buffer_storage, GL_ARB_compute_shader and GL_ARB_shader_storage_buffer_object OpenGL extensions, which are not available.");
+		return false;
+	}
+
+	if (this->is_resolution_scaling_enabled && this->is_frame_stats_enabled == false)
+	{
+		XRBRIDGE_DEBUG_OUT("The resolution scaling needs the GPU timings, enabling the frame statistics.");
+		this->is_frame_stats_enabled = true;
+	}
+
+	if (this->is_just_in_time_enabled && this->is_frame_stats_enabled == false)
+	{
+		XRBRIDGE_DEBUG_OUT("The just-in-time start needs the GPU timings, enabling the frame statistics.");
+		this->is_frame_stats_enabled = true;
+	}
+
+	if (this->is_watchdog_enabled && this->is_frame_stats_enabled == false)
+	{
+		XRBRIDGE_DEBUG_OUT("The overrun watchdog needs the render function timings, enabling the frame statistics.");
+		this->is_frame_stats_enabled = true;
+	}
+
 	XRBRIDGE_DEBUG_OUT("OpenXR version: " << XR_VERSION_MAJOR(XR_CURRENT_API_VERSION) << "." << XR_VERSION_MINOR(XR_CURRENT_API_VERSION) << "." << XR_VERSION_PATCH(XR_CURRENT_API_VERSION));
 
 	XrApplicationInfo application_info = {};
@@ -295,6 +787,36 @@ bool XrBridge::init(const std::string& application_name)
 		}
 	}
 
+	// Load optional extensions
+	// NOTE: These are only requested when the features that need them are enabled. If an
+	//  optional extension is not available, the feature is disabled.
+	const auto request_optional_extension = [&] (const char* extension_name) -> bool
+	{
+		if (is_extension_supported(extension_name))
+		{
+			active_extensions.push_back(extension_name);
+			return true;
+		}
+
+		XRBRIDGE_WARNING_OUT("Optional extension \"" << extension_name << "\" is not available. The features that require it will be disabled.");
+		return false;
+	};
+
+	if (this->is_depth_submission_enabled)
+	{
+		this->is_depth_submission_enabled = request_optional_extension(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+	}
+
+	if (this->is_visibility_mask_enabled)
+	{
+		this->is_visibility_mask_enabled = request_optional_extension(XR_KHR_VISIBILITY_MASK_EXTENSION_NAME);
+	}
+
+	if (this->is_foveation_enabled && this->foveation.is_eye_gaze_enabled)
+	{
+		this->foveation.is_eye_gaze_enabled = request_optional_extension(XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME);
+	}
+
 
 	// Create the OpenXR instance.
 	XrInstanceCreateInfo instance_create_info = {};
@@ -308,7 +830,13 @@ bool XrBridge::init(const std::string& application_name)
 	RETURN_FALSE_ON_OXR_ERROR(xrCreateInstance(&instance_create_info, &this->instance), "Failed to create OpenXR instance.");
 
 
-	// Load extension functions. These need to be loaded manually.
+	// Load the functions used from now on, including the extension functions.
+	if (this->load_dispatch_table() == false)
+	{
+		return false;
+	}
+
+	// Only needed once below, and declared in the platform header, so it is not part of the dispatch table.
 	PFN_xrGetOpenGLGraphicsRequirementsKHR xrGetOpenGLGraphicsRequirementsKHR = nullptr;
 	RETURN_FALSE_ON_OXR_ERROR(xrGetInstanceProcAddr(this->instance, "xrGetOpenGLGraphicsRequirementsKHR", (PFN_xrVoidFunction*)&xrGetOpenGLGraphicsRequirementsKHR), "Failed to get function pointer.");
 
@@ -316,7 +844,7 @@ bool XrBridge::init(const std::string& application_name)
 	// Print some information about the OpenXR instance.
 	XrInstanceProperties instance_properties = {};
 	instance_properties.type = XrStructureType::XR_TYPE_INSTANCE_PROPERTIES;
-	RETURN_FALSE_ON_OXR_ERROR(xrGetInstanceProperties(this->instance, &instance_properties), "Failed to get instance properties.");
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetInstanceProperties(this->instance, &instance_properties), "Failed to get instance properties.");
 	XRBRIDGE_DEBUG_OUT("OpenXR runtime: " << instance_properties.runtimeName << "(" << XR_VERSION_MAJOR(instance_properties.runtimeVersion) << "." << XR_VERSION_MINOR(instance_properties.runtimeVersion) << "." << XR_VERSION_PATCH(instance_properties.runtimeVersion) << ")");
 
 
@@ -326,15 +854,28 @@ bool XrBridge::init(const std::string& application_name)
 	system_info.type = XrStructureType::XR_TYPE_SYSTEM_GET_INFO;
 	// NOTE: This is the form factor that we desire. This use case only requires a HMD.
 	system_info.formFactor = XrFormFactor::XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
-	RETURN_FALSE_ON_OXR_ERROR(xrGetSystem(this->instance, &system_info, &this->system_id), "Failed to get VR system.");
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetSystem(this->instance, &system_info, &this->system_id), "Failed to get VR system.");
 
 
 	// Print the name of the system.
 	XrSystemProperties system_properties = {};
 	system_properties.type = XrStructureType::XR_TYPE_SYSTEM_PROPERTIES;
-	RETURN_FALSE_ON_OXR_ERROR(xrGetSystemProperties(this->instance, this->system_id, &system_properties), "Failed to get VR system properties.");
+	// The extension being available does not mean that the system has eye tracking.
+	XrSystemEyeGazeInteractionPropertiesEXT eye_gaze_properties = {};
+	eye_gaze_properties.type = XrStructureType::XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT;
+	if (this->is_foveation_enabled && this->foveation.is_eye_gaze_enabled)
+	{
+		system_properties.next = &eye_gaze_properties;
+	}
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetSystemProperties(this->instance, this->system_id, &system_properties), "Failed to get VR system properties.");
 	XRBRIDGE_DEBUG_OUT("System name: " << system_properties.systemName);
 
+	if (system_properties.next != nullptr && eye_gaze_properties.supportsEyeGazeInteraction == XR_FALSE)
+	{
+		XRBRIDGE_WARNING_OUT("The system does not support eye tracking. The foveated inset will stay at the center of the views.");
+		this->foveation.is_eye_gaze_enabled = false;
+	}
+
 	// Platform-specific code.
 	#ifdef XRBRIDGE_PLATFORM_WINDOWS
 		XRBRIDGE_DEBUG_OUT("Using platform: Windows (Win32)");
@@ -395,7 +936,19 @@ bool XrBridge::init(const std::string& application_name)
 	session_create_info.next = &graphics_binding;
 	session_create_info.createFlags = NULL_FLAG;
 	session_create_info.systemId = this->system_id;
-	RETURN_FALSE_ON_OXR_ERROR(xrCreateSession(this->instance, &session_create_info, &this->session), "Failed to create OpenXR session.");
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateSession(this->instance, &session_create_info, &this->session), "Failed to create OpenXR session.");
+
+	if (this->is_foveation_enabled && this->foveation.is_eye_gaze_enabled && this->create_eye_gaze_action() == false)
+	{
+		return false;
+	}
+
+	if (this->is_event_thread_enabled)
+	{
+		this->event_thread.should_stop.store(false, std::memory_order_relaxed);
+		this->event_thread.has_failed.store(false, std::memory_order_relaxed);
+		this->event_thread.thread = std::thread(&XrBridge::run_event_thread, this);
+	}
 
 	this->is_already_initialized_flag = true;
 
@@ -406,9 +959,33 @@ bool XrBridge::free()
 {
 	XRBRIDGE_CHECK_INITIALIZED(false);
 
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	// The rendering flag belongs to the render thread while it runs, so it is only checked once
+	//  the thread has been joined.
+	if (this->is_render_thread_enabled)
+	{
+		const bool has_stopped_cleanly = this->stop_render_thread();
+
+		// The render thread cannot be stopped from the render function.
+		if (this->is_render_thread_enabled)
+		{
+			return false;
+		}
+
+		if (has_stopped_cleanly == false)
+		{
+			XRBRIDGE_WARNING_OUT("The render thread stopped because of an error.");
+		}
+	}
+
 	XRBRIDGE_CHECK_RENDERING(true);
 
-	XRBRIDGE_CHECK_DEINITIALIZED(true);
+	if (this->is_event_thread_enabled)
+	{
+		this->event_thread.should_stop.store(true, std::memory_order_release);
+		this->event_thread.thread.join();
+	}
 
 	this->is_already_deinitialized_flag = true;
 
@@ -417,13 +994,19 @@ bool XrBridge::free()
 		return false;
 	}
 
-	if (xrDestroySession(this->session) != XrResult::XR_SUCCESS)
+	if (this->foveation.gaze_space != XR_NULL_HANDLE)
+	{
+		this->dispatch.xrDestroySpace(this->foveation.gaze_space);
+		this->dispatch.xrDestroyActionSet(this->foveation.action_set);
+	}
+
+	if (this->dispatch.xrDestroySession(this->session) != XrResult::XR_SUCCESS)
 	{
 		XRBRIDGE_DEBUG_OUT("Failed to destroy session.");
 		return false;
 	}
 
-	if (xrDestroyInstance(this->instance) != XrResult::XR_SUCCESS)
+	if (this->dispatch.xrDestroyInstance(this->instance) != XrResult::XR_SUCCESS)
 	{
 		XRBRIDGE_DEBUG_OUT("Failed to destroy instance.");
 		return false;
@@ -440,355 +1023,3687 @@ bool XrBridge::update()
 
 	XRBRIDGE_CHECK_DEINITIALIZED(true);
 
-	while (true)
+	if (this->is_event_thread_enabled)
 	{
-		XrEventDataBuffer event_buffer = {};
-		event_buffer.type = XrStructureType::XR_TYPE_EVENT_DATA_BUFFER;
-		const XrResult poll_event_result = xrPollEvent(this->instance, &event_buffer);
+		EventThread& event_thread = this->event_thread;
 
-		if (poll_event_result == XrResult::XR_SUCCESS)
-		{
-			// More events are available, continue.
-		}
-		else if (poll_event_result == XrResult::XR_EVENT_UNAVAILABLE)
+		const uint64_t push_count = event_thread.push_count.load(std::memory_order_acquire);
+		uint64_t pop_count = event_thread.pop_count.load(std::memory_order_relaxed);
+
+		while (pop_count != push_count)
 		{
-			// There are no more events to process, return.
-			break;
+			const Event event = event_thread.events[pop_count % EVENT_QUEUE_SIZE];
+			event_thread.pop_count.store(++pop_count, std::memory_order_release);
+
+			if (this->handle_event(event) == false)
+			{
+				return false;
+			}
 		}
-		else
+
+		if (event_thread.has_failed.load(std::memory_order_acquire))
 		{
-			XRBRIDGE_ERROR_OUT("There was an error while polling for events.");
+			XRBRIDGE_ERROR_OUT("The event thread stopped because of an error.");
 			return false;
 		}
 
+		return true;
+	}
+
+	while (true)
+	{
+		Event event = {};
+		bool has_event = false;
+
+		if (this->poll_event(event, has_event) == false)
+		{
+			return false;
+		}
+
+		// There are no more events to process, return.
+		if (has_event == false)
+		{
+			break;
+		}
+
+		if (this->handle_event(event) == false)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool XrBridge::set_event_thread(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The event thread must be set before calling init()!");
+		return false;
+	}
+
+	this->is_event_thread_enabled = is_enabled;
+
+	return true;
+}
+
+bool XrBridge::poll_event(Event& event, bool& has_event)
+{
+	// NOTE: This may run on the event thread, so it must not touch anything but the instance.
+
+	has_event = false;
+
+	while (true)
+	{
+		XrEventDataBuffer event_buffer = {};
+		event_buffer.type = XrStructureType::XR_TYPE_EVENT_DATA_BUFFER;
+		const XrResult poll_event_result = this->dispatch.xrPollEvent(this->instance, &event_buffer);
+
+		if (poll_event_result == XrResult::XR_EVENT_UNAVAILABLE)
+		{
+			return true;
+		}
+		else if (poll_event_result != XrResult::XR_SUCCESS)
+		{
+			XRBRIDGE_ERROR_OUT("There was an error while polling for events.");
+			return false;
+		}
+
+		event = {};
+
 		switch (event_buffer.type)
 		{
 			// The event queue has overflown and some events were lost.
 		case XrStructureType::XR_TYPE_EVENT_DATA_EVENTS_LOST:
-			XRBRIDGE_WARNING_OUT("The event queue has overflown.");
+			event.type = EventType::EVENTS_LOST;
 			break;
 		case XrStructureType::XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING:
-			// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrEventDataInstanceLossPending.html
-			// As per the documentation: "...indicates that the application is
-			// about to lose the indicated XrInstance..." and "...typically
-			// occurs to make way for a replacement of the underlying runtime...".
-			// In this case, we just generate an error; the user should just restart
-			// the application.
-			XRBRIDGE_ERROR_OUT("The OpenXR instance is about to disconnect.");
-			return false;
+			event.type = EventType::INSTANCE_LOSS_PENDING;
+			break;
+		case XrStructureType::XR_TYPE_EVENT_DATA_VISIBILITY_MASK_CHANGED_KHR:
+		{
+			const XrEventDataVisibilityMaskChangedKHR* visibility_mask_changed = reinterpret_cast<XrEventDataVisibilityMaskChangedKHR*>(&event_buffer);
+
+			event.type = EventType::VISIBILITY_MASK_CHANGED;
+			event.session = visibility_mask_changed->session;
+			event.view_index = visibility_mask_changed->viewIndex;
+			break;
+		}
 		case XrStructureType::XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED:
 		{
 			const XrEventDataSessionStateChanged* session_state_changed = reinterpret_cast<XrEventDataSessionStateChanged*>(&event_buffer);
 
-			if (session_state_changed->session != this->session)
-			{
-				break;
-			}
+			event.type = EventType::SESSION_STATE_CHANGED;
+			event.session = session_state_changed->session;
+			event.session_state = session_state_changed->state;
+			break;
+		}
+		default:
+			// Ignore the events we do not care about.
+			continue;
+		}
+
+		has_event = true;
+
+		return true;
+	}
+}
+
+bool XrBridge::handle_event(const Event& event)
+{
+	switch (event.type)
+	{
+	case EventType::EVENTS_LOST:
+		XRBRIDGE_WARNING_OUT("The event queue has overflown.");
+		break;
+	case EventType::INSTANCE_LOSS_PENDING:
+		// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrEventDataInstanceLossPending.html
+		// As per the documentation: "...indicates that the application is
+		// about to lose the indicated XrInstance..." and "...typically
+		// occurs to make way for a replacement of the underlying runtime...".
+		// In this case, we just generate an error; the user should just restart
+		// the application.
+		XRBRIDGE_ERROR_OUT("The OpenXR instance is about to disconnect.");
+		return false;
+	case EventType::VISIBILITY_MASK_CHANGED:
+		// The masks are retrieved anyway when the session begins.
+		if (event.session != this->session || this->is_visibility_mask_enabled == false || this->swapchains.empty())
+		{
+			break;
+		}
+
+		XRBRIDGE_DEBUG_OUT("The visibility mask of view " << event.view_index << " has changed.");
+
+		if (this->fetch_visibility_mask(event.view_index) == false || this->upload_visibility_masks() == false)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to update the visibility mask.");
+			return false;
+		}
+
+		break;
+	case EventType::SESSION_STATE_CHANGED:
+		if (event.session != this->session)
+		{
+			break;
+		}
+
+		this->session_state = event.session_state;
+
+		if (event.session_state == XrSessionState::XR_SESSION_STATE_READY)
+		{
+			XRBRIDGE_DEBUG_OUT("OpenXR session is beginning.");
+
+			if (this->begin_session() == false)
+			{
+				XRBRIDGE_ERROR_OUT("Failed to begin OpenXR session.");
+				return false;
+			}
+		}
+		else if (event.session_state == XrSessionState::XR_SESSION_STATE_STOPPING)
+		{
+			XRBRIDGE_DEBUG_OUT("OpenXR session is stopping.");
+
+			if (this->end_session() == false)
+			{
+				XRBRIDGE_ERROR_OUT("Failed to end OpenXR session.");
+				return false;
+			}
+		}
+		else if (event.session_state == XrSessionState::XR_SESSION_STATE_LOSS_PENDING)
+		{
+			XRBRIDGE_ERROR_OUT("The OpenXR session is about to be lost.");
+			return false;
+		}
+		else if (event.session_state == XrSessionState::XR_SESSION_STATE_EXITING)
+		{
+			XRBRIDGE_ERROR_OUT("The OpenXR session is about to exit.");
+			return false;
+		}
+
+		break;
+	}
+
+	return true;
+}
+
+void XrBridge::run_event_thread()
+{
+	EventThread& event_thread = this->event_thread;
+
+	while (event_thread.should_stop.load(std::memory_order_acquire) == false)
+	{
+		const uint64_t push_count = event_thread.push_count.load(std::memory_order_relaxed);
+
+		// Leave the events in the runtime while the queue is full, so none is lost.
+		if (push_count - event_thread.pop_count.load(std::memory_order_acquire) >= EVENT_QUEUE_SIZE)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds{ XRBRIDGE_CONFIG_EVENT_THREAD_POLL_INTERVAL });
+			continue;
+		}
+
+		Event& event = event_thread.events[push_count % EVENT_QUEUE_SIZE];
+		bool has_event = false;
+
+		if (this->poll_event(event, has_event) == false)
+		{
+			event_thread.has_failed.store(true, std::memory_order_release);
+			return;
+		}
+
+		if (has_event)
+		{
+			event_thread.push_count.store(push_count + 1, std::memory_order_release);
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds{ XRBRIDGE_CONFIG_EVENT_THREAD_POLL_INTERVAL });
+		}
+	}
+}
+
+bool XrBridge::is_session_running() const
+{
+	return this->is_session_running_flag;
+}
+
+bool XrBridge::wait_for_session_active(const std::chrono::milliseconds timeout)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+	std::chrono::milliseconds interval{ XRBRIDGE_CONFIG_IDLE_POLL_MIN_INTERVAL };
+
+	while (true)
+	{
+		const XrSessionState previous_session_state = this->session_state;
+
+		if (this->update() == false)
+		{
+			return false;
+		}
+
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		if (this->is_session_running_flag || now >= deadline)
+		{
+			return true;
+		}
+
+		// Poll again soon after a change, since the runtime usually sends several in a row.
+		interval = this->session_state != previous_session_state ?
+			std::chrono::milliseconds{ XRBRIDGE_CONFIG_IDLE_POLL_MIN_INTERVAL } :
+			std::min(interval * 2, std::chrono::milliseconds{ XRBRIDGE_CONFIG_IDLE_POLL_MAX_INTERVAL });
+
+		std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(interval, deadline - now));
+	}
+}
+
+bool XrBridge::render(const render_function_t& render_function)
+{
+	FrameToken frame = {};
+	bool is_frame_begun = false;
+
+	if (this->begin_render(frame, is_frame_begun) == false)
+	{
+		return false;
+	}
+
+	if (is_frame_begun == false)
+	{
+		return true;
+	}
+
+	return this->end_frame(frame, render_function);
+}
+
+bool XrBridge::render_stereo(const stereo_render_function_t& stereo_render_function)
+{
+	FrameToken frame = {};
+	bool is_frame_begun = false;
+
+	if (this->begin_render(frame, is_frame_begun) == false)
+	{
+		return false;
+	}
+
+	if (is_frame_begun == false)
+	{
+		return true;
+	}
+
+	return this->end_frame_stereo(frame, stereo_render_function);
+}
+
+bool XrBridge::begin_render(FrameToken& frame, bool& is_frame_begun)
+{
+	is_frame_begun = false;
+
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	// Frames can only be submitted while the session is running.
+	if (this->is_session_running_flag == false)
+	{
+		return true;
+	}
+
+	if (this->wait_frame(frame) == false)
+	{
+		return false;
+	}
+
+	if (this->begin_frame(frame) == false)
+	{
+		return false;
+	}
+
+	is_frame_begun = true;
+
+	return true;
+}
+
+bool XrBridge::wait_frame(FrameToken& frame)
+{
+	// NOTE: We do not check the rendering flag here, since this method may be called
+	// from a different thread while another frame is being rendered.
+
+	XRBRIDGE_CHECK_RENDER_THREAD();
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	frame = {};
+
+	XrFrameState frame_state = {};
+	frame_state.type = XrStructureType::XR_TYPE_FRAME_STATE;
+	XrFrameWaitInfo frame_wait_info = {};
+	frame_wait_info.type = XrStructureType::XR_TYPE_FRAME_WAIT_INFO;
+	// Wait for synchronization with the headset display.
+	// NOTE: The time is stored in the token, since this may run on a different thread.
+	const std::chrono::steady_clock::time_point start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrWaitFrame(this->session, &frame_wait_info, &frame_state), "Faield to wait for frame.");
+	frame.wait_frame_time = this->is_frame_stats_enabled ? get_elapsed_milliseconds(start) : 0.0f;
+	frame.wait_frame_end = this->is_just_in_time_enabled || this->is_slack_tasks_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+	frame.predicted_display_time = frame_state.predictedDisplayTime;
+	frame.predicted_display_period = frame_state.predictedDisplayPeriod;
+	frame.should_render = frame_state.shouldRender == XR_TRUE;
+	frame.is_waited = true;
+
+	return true;
+}
+
+bool XrBridge::begin_frame(FrameToken& frame)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (frame.is_waited == false || frame.is_begun)
+	{
+		XRBRIDGE_ERROR_OUT("The frame must be waited with wait_frame() before being begun, and can only be begun once!");
+		return false;
+	}
+
+	XrFrameBeginInfo frame_begin_info = {};
+	frame_begin_info.type = XrStructureType::XR_TYPE_FRAME_BEGIN_INFO;
+	const std::chrono::steady_clock::time_point start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrBeginFrame(this->session, &frame_begin_info), "Failed to begin frame.");
+	frame.begin_frame_time = this->is_frame_stats_enabled ? get_elapsed_milliseconds(start) : 0.0f;
+
+	frame.is_begun = true;
+
+	return true;
+}
+
+bool XrBridge::end_frame(FrameToken& frame, const render_function_t& render_function)
+{
+	return this->submit_frame(frame, &render_function, nullptr);
+}
+
+bool XrBridge::end_frame_stereo(FrameToken& frame, const stereo_render_function_t& stereo_render_function)
+{
+	return this->submit_frame(frame, nullptr, &stereo_render_function);
+}
+
+bool XrBridge::start_render_thread(const render_function_t& render_function)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->stereo_mode != StereoMode::MULTI_PASS)
+	{
+		XRBRIDGE_ERROR_OUT("Use start_render_thread() with StereoMode::MULTI_PASS, start_render_thread_stereo() otherwise!");
+		return false;
+	}
+
+	return this->launch_render_thread(render_function, nullptr);
+}
+
+bool XrBridge::start_render_thread_stereo(const stereo_render_function_t& stereo_render_function)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->stereo_mode == StereoMode::MULTI_PASS)
+	{
+		XRBRIDGE_ERROR_OUT("Use start_render_thread() with StereoMode::MULTI_PASS, start_render_thread_stereo() otherwise!");
+		return false;
+	}
+
+	return this->launch_render_thread(nullptr, stereo_render_function);
+}
+
+bool XrBridge::stop_render_thread()
+{
+	// NOTE: We do not check the rendering flag here, since it belongs to the render thread.
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	RenderThread& render_thread = this->render_thread;
+
+	if (this->is_render_thread_enabled == false)
+	{
+		XRBRIDGE_ERROR_OUT("The render thread is not running!");
+		return false;
+	}
+
+	if (render_thread_owner == this)
+	{
+		XRBRIDGE_ERROR_OUT("You cannot stop the render thread from the render function!");
+		return false;
+	}
+
+	render_thread.should_stop.store(true, std::memory_order_release);
+	render_thread.thread.join();
+
+	this->is_render_thread_enabled = false;
+
+	// Release the data of the application.
+	render_thread.packets = {};
+	render_thread.packet = {};
+
+	if (render_thread.make_context_current(true) == false)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to make the OpenGL context current again.");
+		return false;
+	}
+
+	if (render_thread.has_failed)
+	{
+		XRBRIDGE_ERROR_OUT("The render thread stopped because of an error.");
+		return false;
+	}
+
+	return true;
+}
+
+bool XrBridge::push_frame_packet(std::shared_ptr<const void> data)
+{
+	// NOTE: We do not check the rendering flag here, since it belongs to the render thread.
+
+	RenderThread& render_thread = this->render_thread;
+
+	if (render_thread.is_running.load(std::memory_order_acquire) == false)
+	{
+		XRBRIDGE_ERROR_OUT("The render thread is not running!");
+		return false;
+	}
+
+	// The back packet is not visible to the render thread. It holds either nothing or a
+	//  packet that has been dropped, which is released here.
+	FramePacket& packet = render_thread.packets[render_thread.back_packet];
+	packet.data = std::move(data);
+	packet.push_time = std::chrono::steady_clock::now();
+
+	// Publish the packet as the newest one, and write the next one in the previous middle packet.
+	const uint32_t previous_middle_packet = render_thread.middle_packet.exchange(render_thread.back_packet | FRESH_FRAME_PACKET_BIT, std::memory_order_acq_rel);
+	render_thread.back_packet = previous_middle_packet & ~FRESH_FRAME_PACKET_BIT;
+
+	// The render thread has not read the previous packet, and never will.
+	if ((previous_middle_packet & FRESH_FRAME_PACKET_BIT) != 0)
+	{
+		render_thread.dropped_packet_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	render_thread.push_count.fetch_add(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+const XrBridge::FramePacket& XrBridge::get_frame_packet() const
+{
+	return this->render_thread.packet;
+}
+
+bool XrBridge::launch_render_thread(const render_function_t& render_function, const stereo_render_function_t& stereo_render_function)
+{
+	RenderThread& render_thread = this->render_thread;
+
+	if (this->is_render_thread_enabled)
+	{
+		XRBRIDGE_ERROR_OUT("The render thread is already running!");
+		return false;
+	}
+
+	// Platform-specific code.
+	#ifdef XRBRIDGE_PLATFORM_WINDOWS
+		const HDC hdc = wglGetCurrentDC();
+		const HGLRC hglrc = wglGetCurrentContext();
+
+		render_thread.make_context_current = [hdc, hglrc] (const bool is_current) {
+			return wglMakeCurrent(is_current ? hdc : NULL, is_current ? hglrc : NULL) == TRUE;
+		};
+	#endif
+	#ifdef XRBRIDGE_PLATFORM_X11
+		Display* const display = glXGetCurrentDisplay();
+		const GLXDrawable drawable = glXGetCurrentDrawable();
+		const GLXContext context = glXGetCurrentContext();
+
+		render_thread.make_context_current = [display, drawable, context] (const bool is_current) {
+			return is_current ?
+				glXMakeCurrent(display, drawable, context) == True :
+				glXMakeCurrent(display, None, nullptr) == True;
+		};
+	#endif
+
+	// A context can only be current on one thread at a time.
+	if (render_thread.make_context_current(false) == false)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to release the OpenGL context.");
+		return false;
+	}
+
+	render_thread.packets = {};
+	render_thread.back_packet = 0;
+	render_thread.front_packet = 1;
+	render_thread.middle_packet.store(2, std::memory_order_relaxed);
+	render_thread.push_count.store(0, std::memory_order_relaxed);
+	render_thread.pop_count = 0;
+	render_thread.dropped_packet_count.store(0, std::memory_order_relaxed);
+	render_thread.packet = {};
+	render_thread.queue_depth = 0;
+	render_thread.should_stop.store(false, std::memory_order_relaxed);
+	render_thread.has_failed = false;
+	render_thread.stats = this->compute_frame_stats();
+	render_thread.is_running.store(true, std::memory_order_release);
+
+	this->is_render_thread_enabled = true;
+
+	render_thread.thread = std::thread(&XrBridge::run_render_thread, this, render_function, stereo_render_function);
+
+	return true;
+}
+
+void XrBridge::run_render_thread(const render_function_t& render_function, const stereo_render_function_t& stereo_render_function)
+{
+	RenderThread& render_thread = this->render_thread;
+
+	render_thread_owner = this;
+
+	bool has_failed = render_thread.make_context_current(true) == false;
+
+	if (has_failed)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to make the OpenGL context current on the render thread.");
+	}
+
+	uint64_t frame_index = 0;
+
+	while (has_failed == false && render_thread.should_stop.load(std::memory_order_acquire) == false)
+	{
+		if (this->is_session_running_flag == false)
+		{
+			// Keep checking whether the thread should stop while the headset is not in use.
+			has_failed = this->wait_for_session_active(std::chrono::milliseconds{ 100 }) == false;
+			continue;
+		}
+
+		if (this->update() == false)
+		{
+			has_failed = true;
+			break;
+		}
+
+		this->pop_frame_packets();
+
+		const bool did_render = render_function != nullptr ?
+			this->render(render_function) :
+			this->render_stereo(stereo_render_function);
+
+		if (did_render == false)
+		{
+			has_failed = true;
+			break;
+		}
+
+		if (this->is_frame_stats_enabled && ++frame_index % XRBRIDGE_CONFIG_RENDER_THREAD_STATS_INTERVAL == 0)
+		{
+			const FrameStats stats = this->compute_frame_stats();
+
+			std::lock_guard<std::mutex> lock(render_thread.stats_mutex);
+			render_thread.stats = stats;
+		}
+	}
+
+	render_thread.make_context_current(false);
+
+	render_thread_owner = nullptr;
+
+	render_thread.has_failed = has_failed;
+	render_thread.is_running.store(false, std::memory_order_release);
+}
+
+bool XrBridge::is_used_by_render_thread() const
+{
+	// The flag is only written by the thread that starts and stops the render thread, before
+	//  starting it and after joining it.
+	return this->is_render_thread_enabled && render_thread_owner != this;
+}
+
+void XrBridge::pop_frame_packets()
+{
+	RenderThread& render_thread = this->render_thread;
+
+	const uint64_t push_count = render_thread.push_count.load(std::memory_order_relaxed);
+	render_thread.queue_depth = static_cast<uint32_t>(push_count - render_thread.pop_count);
+	render_thread.pop_count = push_count;
+
+	// Keep rendering the current packet until a newer one is pushed.
+	if ((render_thread.middle_packet.load(std::memory_order_relaxed) & FRESH_FRAME_PACKET_BIT) == 0)
+	{
+		return;
+	}
+
+	// Take the newest packet, and give back the front one, which has already been moved out.
+	const uint32_t previous_middle_packet = render_thread.middle_packet.exchange(render_thread.front_packet, std::memory_order_acq_rel);
+	render_thread.front_packet = previous_middle_packet & ~FRESH_FRAME_PACKET_BIT;
+	render_thread.packet = std::move(render_thread.packets[render_thread.front_packet]);
+}
+
+void XrBridge::set_clipping_planes(const float near_clipping_plane, const float far_clipping_plane)
+{
+	if (this->is_used_by_render_thread())
+	{
+		XRBRIDGE_ERROR_OUT("You cannot call this function while the render thread is running!");
+		return;
+	}
+
+	this->near_clipping_plane = near_clipping_plane;
+	this->far_clipping_plane = far_clipping_plane;
+}
+
+bool XrBridge::set_stereo_mode(const StereoMode stereo_mode)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The stereo mode must be set before calling init()!");
+		return false;
+	}
+
+	this->stereo_mode = stereo_mode;
+
+	return true;
+}
+
+bool XrBridge::set_depth_format(const DepthFormat depth_format)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The depth format must be set before calling init()!");
+		return false;
+	}
+
+	this->depth_format = depth_format;
+
+	return true;
+}
+
+uint64_t XrBridge::get_saved_depth_memory() const
+{
+	return this->saved_depth_memory;
+}
+
+bool XrBridge::set_depth_submission(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The depth submission must be set before calling init()!");
+		return false;
+	}
+
+	this->is_depth_submission_enabled = is_enabled;
+
+	return true;
+}
+
+bool XrBridge::set_visibility_mask(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The visibility mask must be set before calling init()!");
+		return false;
+	}
+
+	this->is_visibility_mask_enabled = is_enabled;
+
+	return true;
+}
+
+float XrBridge::get_visibility_mask_culled_ratio(const Eye eye) const
+{
+	if (this->is_visibility_mask_enabled == false)
+	{
+		return 0.0f;
+	}
+
+	return this->visibility_masks[eye == Eye::LEFT ? 0 : 1].culled_ratio;
+}
+
+bool XrBridge::set_frame_stats(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The frame statistics must be set before calling init()!");
+		return false;
+	}
+
+	this->is_frame_stats_enabled = is_enabled;
+
+	return true;
+}
+
+XrBridge::FrameStats XrBridge::get_frame_stats() const
+{
+	// The statistics are being written by the render thread.
+	if (this->render_thread.is_running.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(this->render_thread.stats_mutex);
+		return this->render_thread.stats;
+	}
+
+	return this->compute_frame_stats();
+}
+
+XrBridge::FrameStats XrBridge::compute_frame_stats() const
+{
+	FrameStats stats = {};
+
+	if (this->is_frame_stats_enabled == false)
+	{
+		return stats;
+	}
+
+	const auto get_timing_stats = [this] (const Timing timing) {
+		const TimingWindow& window = this->frame_stats.windows[static_cast<size_t>(timing)];
+
+		TimingStats timing_stats = {};
+
+		if (window.sample_count == 0)
+		{
+			return timing_stats;
+		}
+
+		// Sort a copy of the samples, so that the window is left untouched.
+		std::array<float, FRAME_STATS_WINDOW_SIZE> samples = window.samples;
+		std::sort(samples.begin(), samples.begin() + window.sample_count);
+
+		const auto get_percentile = [&] (const float percentile) {
+			const uint32_t index = static_cast<uint32_t>(std::ceil(percentile * window.sample_count)) - 1;
+			return samples[glm::min(index, window.sample_count - 1)];
+		};
+
+		timing_stats.p50 = get_percentile(0.50f);
+		timing_stats.p95 = get_percentile(0.95f);
+		timing_stats.p99 = get_percentile(0.99f);
+
+		return timing_stats;
+	};
+
+	stats.frame_count = this->frame_stats.frame_count;
+	stats.missed_frame_count = this->frame_stats.missed_frame_count;
+	stats.wait_frame = get_timing_stats(Timing::WAIT_FRAME);
+	stats.begin_frame = get_timing_stats(Timing::BEGIN_FRAME);
+	stats.acquire_image = get_timing_stats(Timing::ACQUIRE_IMAGE);
+	stats.wait_image = get_timing_stats(Timing::WAIT_IMAGE);
+	stats.eye_wait_image[0] = get_timing_stats(Timing::WAIT_IMAGE_LEFT);
+	stats.eye_wait_image[1] = get_timing_stats(Timing::WAIT_IMAGE_RIGHT);
+	stats.wait_image_timeout_count = this->frame_stats.wait_image_timeout_count;
+	stats.render_function = get_timing_stats(Timing::RENDER_FUNCTION);
+	stats.end_frame = get_timing_stats(Timing::END_FRAME);
+	stats.gpu_time[0] = get_timing_stats(Timing::GPU_LEFT);
+	stats.gpu_time[1] = get_timing_stats(Timing::GPU_RIGHT);
+	stats.pose_to_end_frame = get_timing_stats(Timing::POSE_TO_END_FRAME);
+	stats.frames_in_flight_wait = get_timing_stats(Timing::FRAMES_IN_FLIGHT_WAIT);
+	stats.frame_packet_age = get_timing_stats(Timing::FRAME_PACKET_AGE);
+	stats.just_in_time_sleep = get_timing_stats(Timing::JUST_IN_TIME_SLEEP);
+	stats.just_in_time_margin = this->just_in_time.margin;
+	stats.slack_tasks = get_timing_stats(Timing::SLACK_TASKS);
+	stats.pending_slack_task_count = static_cast<uint32_t>(this->slack_tasks.size());
+	stats.overrun_count = this->watchdog.overrun_count;
+	stats.frame_packet_queue_depth = this->render_thread.queue_depth;
+	stats.dropped_frame_packet_count = this->render_thread.dropped_packet_count.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+bool XrBridge::set_resolution_scaling(const bool is_enabled, const float min_scale, const float max_scale, const float hysteresis)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The resolution scaling must be set before calling init()!");
+		return false;
+	}
+
+	if (min_scale <= 0.0f || min_scale > max_scale || hysteresis < 0.0f || hysteresis >= 1.0f)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid resolution scaling settings: the scales must be positive with min_scale <= max_scale, and the hysteresis must be between 0 and 1.");
+		return false;
+	}
+
+	this->is_resolution_scaling_enabled = is_enabled;
+	this->resolution_scaling.min_scale = min_scale;
+	this->resolution_scaling.max_scale = max_scale;
+	this->resolution_scaling.hysteresis = hysteresis;
+
+	return true;
+}
+
+float XrBridge::get_resolution_scale() const
+{
+	if (this->is_resolution_scaling_enabled == false)
+	{
+		return 1.0f;
+	}
+
+	return this->resolution_scaling.scale;
+}
+
+bool XrBridge::set_foveation(const bool is_enabled, const float inset_size, const float peripheral_scale, const bool use_eye_gaze)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The foveation must be set before calling init()!");
+		return false;
+	}
+
+	if (inset_size <= 0.0f || inset_size > 1.0f || peripheral_scale <= 0.0f || peripheral_scale > 1.0f)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid foveation settings: the inset size and the peripheral scale must be between 0 and 1.");
+		return false;
+	}
+
+	this->is_foveation_enabled = is_enabled;
+	this->foveation.inset_size = inset_size;
+	this->foveation.peripheral_scale = peripheral_scale;
+	this->foveation.is_eye_gaze_enabled = use_eye_gaze;
+
+	return true;
+}
+
+XrRect2Di XrBridge::get_foveation_inset(const Eye eye) const
+{
+	if (this->is_foveation_enabled == false)
+	{
+		return {};
+	}
+
+	return this->foveation.inset_rects[eye == Eye::LEFT ? 0 : 1];
+}
+
+bool XrBridge::set_density_mask(const bool is_enabled, const float inner_radius, const float outer_radius)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The density mask must be set before calling init()!");
+		return false;
+	}
+
+	if (inner_radius < 0.0f || inner_radius > outer_radius)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid density mask settings: the radii must be positive with inner_radius <= outer_radius.");
+		return false;
+	}
+
+	this->is_density_mask_enabled = is_enabled;
+	this->density_mask.inner_radius = inner_radius;
+	this->density_mask.outer_radius = outer_radius;
+
+	return true;
+}
+
+bool XrBridge::set_frame_reuse(const bool is_enabled, const float position_epsilon, const float angle_epsilon)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The frame reuse must be set before calling init()!");
+		return false;
+	}
+
+	if (position_epsilon < 0.0f || angle_epsilon < 0.0f)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid frame reuse settings: the epsilons must be positive.");
+		return false;
+	}
+
+	this->is_frame_reuse_enabled = is_enabled;
+	this->frame_reuse.position_epsilon = position_epsilon;
+	this->frame_reuse.angle_epsilon = angle_epsilon;
+
+	return true;
+}
+
+bool XrBridge::mark_scene_clean()
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	this->frame_reuse.is_scene_clean = true;
+
+	return true;
+}
+
+uint64_t XrBridge::get_reused_frame_count() const
+{
+	if (this->is_frame_reuse_enabled == false)
+	{
+		return 0;
+	}
+
+	return this->frame_reuse.reused_frame_count;
+}
+
+bool XrBridge::set_late_latching(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The late latching must be set before calling init()!");
+		return false;
+	}
+
+	this->is_late_latching_enabled = is_enabled;
+
+	return true;
+}
+
+bool XrBridge::set_frames_in_flight(const bool is_enabled, const uint32_t max_frames_in_flight)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The frames in flight must be set before calling init()!");
+		return false;
+	}
+
+	if (max_frames_in_flight < 1 || max_frames_in_flight > MAX_FRAMES_IN_FLIGHT)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid frames in flight settings: max_frames_in_flight must be between 1 and " << MAX_FRAMES_IN_FLIGHT << ".");
+		return false;
+	}
+
+	this->is_frames_in_flight_enabled = is_enabled;
+	this->frames_in_flight.max_frames_in_flight = max_frames_in_flight;
+
+	return true;
+}
+
+bool XrBridge::set_pre_pass_function(const pre_pass_function_t& pre_pass_function)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	this->pre_pass_function = pre_pass_function;
+
+	return true;
+}
+
+bool XrBridge::set_just_in_time_start(const bool is_enabled, const float min_margin, const float max_margin)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The just-in-time start must be set before calling init()!");
+		return false;
+	}
+
+	if (min_margin <= 0.0f || min_margin > max_margin)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid just-in-time start settings: the margins must be positive with min_margin <= max_margin.");
+		return false;
+	}
+
+	this->is_just_in_time_enabled = is_enabled;
+	this->just_in_time = {};
+	this->just_in_time.min_margin = min_margin;
+	this->just_in_time.max_margin = max_margin;
+	this->just_in_time.margin = min_margin;
+
+	return true;
+}
+
+bool XrBridge::set_overrun_watchdog(const bool is_enabled, const DegradationLevel max_level, const float overrun_threshold, const float recovery_threshold)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The overrun watchdog must be set before calling init()!");
+		return false;
+	}
+
+	if (recovery_threshold <= 0.0f || recovery_threshold >= overrun_threshold)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid overrun watchdog settings: the thresholds must be positive with recovery_threshold < overrun_threshold.");
+		return false;
+	}
+
+	this->is_watchdog_enabled = is_enabled;
+	this->watchdog = {};
+	this->watchdog.max_level = max_level;
+	this->watchdog.overrun_threshold = overrun_threshold;
+	this->watchdog.recovery_threshold = recovery_threshold;
+
+	return true;
+}
+
+XrBridge::DegradationLevel XrBridge::get_degradation_level() const
+{
+	return this->watchdog.level;
+}
+
+bool XrBridge::set_slack_tasks(const bool is_enabled, const float reserve)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The slack tasks must be set before calling init()!");
+		return false;
+	}
+
+	if (reserve < 0.0f)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid slack tasks settings: the reserve must not be negative.");
+		return false;
+	}
+
+	this->is_slack_tasks_enabled = is_enabled;
+	this->slack_reserve = reserve;
+
+	return true;
+}
+
+bool XrBridge::add_slack_task(const slack_task_t& task)
+{
+	// NOTE: We do not check the rendering flag here, since the slack tasks may add more tasks.
+
+	XRBRIDGE_CHECK_RENDER_THREAD();
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_slack_tasks_enabled == false)
+	{
+		XRBRIDGE_ERROR_OUT("The slack tasks are not enabled! Refer to set_slack_tasks().");
+		return false;
+	}
+
+	if (task == nullptr)
+	{
+		XRBRIDGE_ERROR_OUT("The slack task is empty!");
+		return false;
+	}
+
+	this->slack_tasks.push_back(task);
+
+	return true;
+}
+
+bool XrBridge::set_direct_dispatch(const bool is_enabled)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (this->is_already_initialized_flag)
+	{
+		XRBRIDGE_ERROR_OUT("The direct dispatch must be set before calling init()!");
+		return false;
+	}
+
+	this->is_direct_dispatch_enabled = is_enabled;
+
+	return true;
+}
+
+bool XrBridge::load_dispatch_table()
+{
+	XRBRIDGE_LOAD_FUNCTION(xrAcquireSwapchainImage);
+	XRBRIDGE_LOAD_FUNCTION(xrAttachSessionActionSets);
+	XRBRIDGE_LOAD_FUNCTION(xrBeginFrame);
+	XRBRIDGE_LOAD_FUNCTION(xrBeginSession);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateAction);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateActionSet);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateActionSpace);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateReferenceSpace);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateSession);
+	XRBRIDGE_LOAD_FUNCTION(xrCreateSwapchain);
+	XRBRIDGE_LOAD_FUNCTION(xrDestroyActionSet);
+	XRBRIDGE_LOAD_FUNCTION(xrDestroyInstance);
+	XRBRIDGE_LOAD_FUNCTION(xrDestroySession);
+	XRBRIDGE_LOAD_FUNCTION(xrDestroySpace);
+	XRBRIDGE_LOAD_FUNCTION(xrDestroySwapchain);
+	XRBRIDGE_LOAD_FUNCTION(xrEndFrame);
+	XRBRIDGE_LOAD_FUNCTION(xrEndSession);
+	XRBRIDGE_LOAD_FUNCTION(xrEnumerateSwapchainFormats);
+	XRBRIDGE_LOAD_FUNCTION(xrEnumerateSwapchainImages);
+	XRBRIDGE_LOAD_FUNCTION(xrEnumerateViewConfigurationViews);
+	XRBRIDGE_LOAD_FUNCTION(xrGetInstanceProperties);
+	XRBRIDGE_LOAD_FUNCTION(xrGetSystem);
+	XRBRIDGE_LOAD_FUNCTION(xrGetSystemProperties);
+	XRBRIDGE_LOAD_FUNCTION(xrLocateSpace);
+	XRBRIDGE_LOAD_FUNCTION(xrLocateViews);
+	XRBRIDGE_LOAD_FUNCTION(xrPollEvent);
+	XRBRIDGE_LOAD_FUNCTION(xrReleaseSwapchainImage);
+	XRBRIDGE_LOAD_FUNCTION(xrStringToPath);
+	XRBRIDGE_LOAD_FUNCTION(xrSuggestInteractionProfileBindings);
+	XRBRIDGE_LOAD_FUNCTION(xrSyncActions);
+	XRBRIDGE_LOAD_FUNCTION(xrWaitFrame);
+	XRBRIDGE_LOAD_FUNCTION(xrWaitSwapchainImage);
+
+	// Optional extensions.
+	if (this->is_visibility_mask_enabled)
+	{
+		XRBRIDGE_LOAD_EXTENSION_FUNCTION(xrGetVisibilityMaskKHR);
+	}
+
+	return true;
+}
+
+bool XrBridge::begin_session()
+{
+	XrSessionBeginInfo session_begin_info = {};
+	session_begin_info.type = XrStructureType::XR_TYPE_SESSION_BEGIN_INFO;
+	// NOTE: This is the view cofiguration type that we desire. This use case only requires stereo (two eyes).
+	session_begin_info.primaryViewConfigurationType = XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrBeginSession(this->session, &session_begin_info), "Faield to begin session.");
+
+	// A view more or less equates to a display. In the case of a VR headset, since we have 2 eyes, we will ave 2 views.
+	uint32_t view_count = 0;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateViewConfigurationViews(this->instance, this->system_id, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 0, &view_count, nullptr), "Faield to enumerate view configuration views.");
+	std::vector<XrViewConfigurationView> view_configuration_views(view_count, { XR_TYPE_VIEW_CONFIGURATION_VIEW });
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateViewConfigurationViews(this->instance, this->system_id, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_count, &view_count, view_configuration_views.data()), "Faield to enumerate view configuration views.");
+
+	if (view_count != MAX_VIEWS)
+	{
+		XRBRIDGE_ERROR_OUT("OpenXR is reporting " << view_count << " views, but only " << MAX_VIEWS << " are supported.");
+		return false;
+	}
+
+	if (this->is_depth_submission_enabled && this->select_depth_swapchain_format() == false)
+	{
+		return false;
+	}
+
+	// In MULTI_PASS mode each eye has its own swapchain. Otherwise, both eyes share a single swapchain.
+	const uint32_t swapchain_count = this->stereo_mode == StereoMode::MULTI_PASS ? view_count : 1;
+
+	this->saved_depth_memory = 0;
+
+	for (uint32_t swapchain_index = 0; swapchain_index < swapchain_count; ++swapchain_index)
+	{
+		const XrViewConfigurationView& view_configuration_view = view_configuration_views[swapchain_index];
+
+		uint32_t view_width = view_configuration_view.recommendedImageRectWidth;
+		uint32_t view_height = view_configuration_view.recommendedImageRectHeight;
+
+		// When the resolution is scaled, the images must be large enough for the maximum scale.
+		if (this->is_resolution_scaling_enabled)
+		{
+			const float max_scale = this->resolution_scaling.max_scale;
+			view_width = glm::min(static_cast<uint32_t>(std::ceil(view_width * max_scale)), view_configuration_view.maxImageRectWidth);
+			view_height = glm::min(static_cast<uint32_t>(std::ceil(view_height * max_scale)), view_configuration_view.maxImageRectHeight);
+		}
+
+		Swapchain swapchain = {};
+		swapchain.view_count = this->stereo_mode == StereoMode::MULTI_PASS ? 1 : view_count;
+		// With MULTIVIEW, each eye is rendered to its own array layer.
+		swapchain.array_size = this->stereo_mode == StereoMode::MULTIVIEW ? view_count : 1;
+		// With INSTANCED, the eyes are placed side by side.
+		swapchain.width = this->stereo_mode == StereoMode::INSTANCED ? view_width * view_count : view_width;
+		swapchain.height = view_height;
+
+		for (uint32_t view_index = 0; view_index < swapchain.view_count; ++view_index)
+		{
+			XrRect2Di& view_rect = swapchain.view_rects[view_index];
+			view_rect.offset.x = this->stereo_mode == StereoMode::INSTANCED ? static_cast<int32_t>(view_width * view_index) : 0;
+			view_rect.offset.y = 0;
+			view_rect.extent.width = static_cast<int32_t>(view_width);
+			view_rect.extent.height = static_cast<int32_t>(view_height);
+		}
+
+		XrSwapchainCreateInfo swapchain_create_info = {};
+		swapchain_create_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_CREATE_INFO;
+		swapchain_create_info.createFlags = NULL_FLAG;
+		// OpenGL does not support usage flags.
+		swapchain_create_info.usageFlags = NULL_FLAG;
+		swapchain_create_info.format = XRBRIDGE_SWAPCHAIN_FORMAT;
+		swapchain_create_info.width = swapchain.width;
+		swapchain_create_info.height = swapchain.height;
+		swapchain_create_info.sampleCount = view_configuration_view.recommendedSwapchainSampleCount;
+		swapchain_create_info.faceCount = 1;
+		swapchain_create_info.arraySize = swapchain.array_size;
+		swapchain_create_info.mipCount = 1;
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateSwapchain(this->session, &swapchain_create_info, &swapchain.swapchain), "Failed to create swapchain.");
+
+		// Create the single images inside the swapchain.
+		// If the runtime is using double-buffering, there will be 2 images per swapchain. For triple buffering,
+		//  the images will be 3.
+		uint32_t swapchain_image_count = 0;
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainImages(swapchain.swapchain, 0, &swapchain_image_count, nullptr), "Failed to enumerate swapchain images.");
+		std::vector<XrSwapchainImageOpenGLKHR> swapchain_images(swapchain_image_count, { XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR }); // NOTE: Change this to use another graphics API.
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainImages(swapchain.swapchain, swapchain_image_count, &swapchain_image_count, reinterpret_cast<XrSwapchainImageBaseHeader*>(swapchain_images.data())), "Failed to enumerate swapchain images.");
+
+		for (const auto& swapchain_image : swapchain_images)
+		{
+			swapchain.color_images.push_back(swapchain_image.image);
+		}
+
+		if (this->is_depth_submission_enabled)
+		{
+			// The depth is submitted to the runtime, so it is rendered directly to the images
+			//  of a depth swapchain. The FBOs are attached to the acquired depth image each frame.
+			swapchain_create_info.usageFlags = XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			swapchain_create_info.format = get_depth_format_internal_format(this->depth_format);
+			RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateSwapchain(this->session, &swapchain_create_info, &swapchain.depth_swapchain), "Failed to create depth swapchain.");
+
+			uint32_t depth_image_count = 0;
+			RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainImages(swapchain.depth_swapchain, 0, &depth_image_count, nullptr), "Failed to enumerate depth swapchain images.");
+			std::vector<XrSwapchainImageOpenGLKHR> depth_images(depth_image_count, { XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR });
+			RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainImages(swapchain.depth_swapchain, depth_image_count, &depth_image_count, reinterpret_cast<XrSwapchainImageBaseHeader*>(depth_images.data())), "Failed to enumerate depth swapchain images.");
+
+			for (const auto& depth_image : depth_images)
+			{
+				swapchain.depth_images.push_back(depth_image.image);
+			}
+		}
+		else
+		{
+			// All of the images of the swapchain share the same depth buffer, since only one
+			//  of them is rendered at a time.
+			swapchain.depth_texture = this->create_depth_texture(swapchain);
+		}
+
+		for (const auto& swapchain_image : swapchain_images)
+		{
+			const GLuint depth = this->is_depth_submission_enabled ? swapchain.depth_images[0] : swapchain.depth_texture;
+			const std::shared_ptr<Fbo> fbo = this->create_fbo(swapchain_image.image, depth, swapchain);
+
+			if (fbo == nullptr)
+			{
+				XRBRIDGE_ERROR_OUT("Failed to create FBO.");
+				return false;
+			}
+
+			swapchain.framebuffers.push_back(fbo);
+		}
+
+		if (this->is_depth_submission_enabled == false)
+		{
+			const uint64_t depth_size = get_depth_format_size(this->depth_format) * swapchain.width * swapchain.height * swapchain.array_size;
+			this->saved_depth_memory += depth_size * (swapchain_image_count - 1);
+			XRBRIDGE_DEBUG_OUT("Depth buffer: " << (depth_size >> 20) << " MiB shared by " << swapchain_image_count << " images (saved " << ((depth_size * (swapchain_image_count - 1)) >> 20) << " MiB).");
+		}
+
+		this->swapchains.push_back(swapchain);
+	}
+
+	// With foveated rendering, the periphery of each view is rendered to a smaller FBO.
+	if (this->is_foveation_enabled)
+	{
+		for (uint32_t view_index = 0; view_index < view_count; ++view_index)
+		{
+			const Swapchain& swapchain = this->swapchains[view_index];
+
+			Swapchain peripheral_buffer = {};
+			peripheral_buffer.view_count = 1;
+			peripheral_buffer.array_size = 1;
+			peripheral_buffer.width = glm::max(1u, static_cast<uint32_t>(swapchain.width * this->foveation.peripheral_scale));
+			peripheral_buffer.height = glm::max(1u, static_cast<uint32_t>(swapchain.height * this->foveation.peripheral_scale));
+			peripheral_buffer.view_rects[0] = { { 0, 0 }, { static_cast<int32_t>(peripheral_buffer.width), static_cast<int32_t>(peripheral_buffer.height) } };
+
+			GLuint& color_texture = this->foveation.peripheral_color_textures[view_index];
+			glGenTextures(1, &color_texture);
+			glBindTexture(GL_TEXTURE_2D, color_texture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, XRBRIDGE_SWAPCHAIN_FORMAT, peripheral_buffer.width, peripheral_buffer.height);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			peripheral_buffer.depth_texture = this->create_depth_texture(peripheral_buffer);
+
+			const std::shared_ptr<Fbo> fbo = this->create_fbo(color_texture, peripheral_buffer.depth_texture, peripheral_buffer);
+
+			if (fbo == nullptr)
+			{
+				XRBRIDGE_ERROR_OUT("Failed to create the FBO of the periphery.");
+				return false;
+			}
+
+			peripheral_buffer.framebuffers.push_back(fbo);
+			this->foveation.peripheral_buffers.push_back(peripheral_buffer);
+		}
+	}
+
+	// The stereo render function receives the matrices of both eyes in a uniform buffer.
+	// When late latching, the buffer is used by every stereo mode and is only written by the GPU,
+	//  which copies the matrices from a staging buffer written through a persistent mapping.
+	if (this->is_late_latching_enabled)
+	{
+		static_assert(sizeof(StereoMatrices) == 24 * sizeof(glm::vec4), "The late latching copy shader moves 24 vectors per slot.");
+
+		LateLatching& late_latching = this->late_latching;
+
+		const GLbitfield staging_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &late_latching.staging_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, late_latching.staging_buffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, LATE_LATCHING_STAGING_SIZE, nullptr, staging_flags);
+		late_latching.mapped_staging_buffer = static_cast<uint8_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, LATE_LATCHING_STAGING_SIZE, staging_flags));
+
+		const GLbitfield copied_slot_flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &late_latching.copied_slot_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, late_latching.copied_slot_buffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), nullptr, copied_slot_flags);
+		late_latching.mapped_copied_slot_buffer = static_cast<const uint32_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), copied_slot_flags));
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		if (late_latching.mapped_staging_buffer == nullptr || late_latching.mapped_copied_slot_buffer == nullptr)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to map the late latching buffers.");
+			return false;
+		}
+
+		late_latching.copy_shader = create_compute_program(std::string("#version 440 core\n") + LATE_LATCHING_COPY_SHADER_SOURCE);
+
+		if (late_latching.copy_shader == 0)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to create the late latching shader.");
+			return false;
+		}
+	}
+
+	if (this->is_late_latching_enabled || this->stereo_mode != StereoMode::MULTI_PASS)
+	{
+		glGenBuffers(1, &this->stereo_matrices_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, this->stereo_matrices_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(StereoMatrices), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	// Create the reference space.
+	XrReferenceSpaceCreateInfo reference_space_info = {};
+	reference_space_info.type = XrStructureType::XR_TYPE_REFERENCE_SPACE_CREATE_INFO;
+	// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrReferenceSpaceType.html
+	reference_space_info.referenceSpaceType = XRBRIDGE_CONFIG_SPACE;
+	// Here we set the offset to the origin of the tracking space. In this case, we keep the origin were it is.
+	reference_space_info.poseInReferenceSpace = {
+		{ 0.0f, 0.0f, 0.0f, 1.0f, }, // Orientation
+		{ 0.0f, 0.0f, 0.0f }, // Position
+	};
+
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateReferenceSpace(this->session, &reference_space_info, &this->space), "Failed to create reference space.");
+
+	// The shaders used by XrBridge must match the way the views are rendered.
+	std::string vertex_shader_header = "#version 440 core\n";
+	std::string fragment_shader_header = "#version 440 core\n";
+	if (this->stereo_mode == StereoMode::MULTIVIEW)
+	{
+		vertex_shader_header += "#extension GL_OVR_multiview2 : require\nlayout(num_views = 2) in;\n#define XRBRIDGE_MULTIVIEW\n";
+		fragment_shader_header += "#define XRBRIDGE_MULTIVIEW\n";
+	}
+	else if (this->stereo_mode == StereoMode::INSTANCED)
+	{
+		vertex_shader_header += "#extension GL_ARB_shader_viewport_layer_array : require\n#define XRBRIDGE_INSTANCED\n";
+		fragment_shader_header += "#define XRBRIDGE_INSTANCED\n";
+	}
+
+	// Retrieve the visibility masks and prepare everything that is needed to draw them.
+	if (this->is_visibility_mask_enabled)
+	{
+		for (uint32_t view_index = 0; view_index < view_count; ++view_index)
+		{
+			if (this->fetch_visibility_mask(view_index) == false)
+			{
+				return false;
+			}
+		}
+
+		this->visibility_mask_shader = create_program(vertex_shader_header + VISIBILITY_MASK_VERTEX_SHADER_SOURCE, VISIBILITY_MASK_FRAGMENT_SHADER_SOURCE);
+		if (this->visibility_mask_shader == 0)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to create the visibility mask shader.");
+			return false;
+		}
+
+		glGenVertexArrays(1, &this->visibility_mask_vao);
+		glGenBuffers(1, &this->visibility_mask_vbo);
+
+		glBindVertexArray(this->visibility_mask_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, this->visibility_mask_vbo);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		if (this->upload_visibility_masks() == false)
+		{
+			return false;
+		}
+	}
+
+	if (this->is_density_mask_enabled)
+	{
+		DensityMask& density_mask = this->density_mask;
+
+		density_mask.mask_shader = create_program(
+			vertex_shader_header + DENSITY_MASK_VERTEX_SHADER_SOURCE,
+			fragment_shader_header + DENSITY_MASK_COMMON_SHADER_SOURCE + DENSITY_MASK_FRAGMENT_SHADER_SOURCE);
+		density_mask.reconstruction_shader = create_program(
+			vertex_shader_header + DENSITY_MASK_VERTEX_SHADER_SOURCE,
+			fragment_shader_header + DENSITY_MASK_COMMON_SHADER_SOURCE + DENSITY_MASK_RECONSTRUCTION_FRAGMENT_SHADER_SOURCE);
+
+		if (density_mask.mask_shader == 0 || density_mask.reconstruction_shader == 0)
+		{
+			XRBRIDGE_ERROR_OUT("Failed to create the density mask shaders.");
+			return false;
+		}
+
+		glGenVertexArrays(1, &density_mask.vao);
+
+		// The reconstruction reads the rendered image from a copy. The copy is not sRGB,
+		//  so that the values are read and written back without any conversion.
+		for (const Swapchain& swapchain : this->swapchains)
+		{
+			const GLenum target = swapchain.array_size > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+
+			GLuint scratch_texture = 0;
+			glGenTextures(1, &scratch_texture);
+			glBindTexture(target, scratch_texture);
+
+			if (target == GL_TEXTURE_2D_ARRAY)
+			{
+				glTexStorage3D(target, 1, GL_RGBA8, swapchain.width, swapchain.height, swapchain.array_size);
+			}
+			else
+			{
+				glTexStorage2D(target, 1, GL_RGBA8, swapchain.width, swapchain.height);
+			}
+
+			glBindTexture(target, 0);
+
+			density_mask.scratch_textures.push_back(scratch_texture);
+		}
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		for (std::array<GLuint, MAX_VIEWS>& gpu_queries : this->frame_stats.gpu_queries)
+		{
+			glGenQueries(MAX_VIEWS, gpu_queries.data());
+		}
+	}
+
+	if (this->is_resolution_scaling_enabled)
+	{
+		ResolutionScaling& resolution_scaling = this->resolution_scaling;
+
+		for (uint32_t view_index = 0; view_index < view_count; ++view_index)
+		{
+			resolution_scaling.recommended_extents[view_index].width = static_cast<int32_t>(view_configuration_views[view_index].recommendedImageRectWidth);
+			resolution_scaling.recommended_extents[view_index].height = static_cast<int32_t>(view_configuration_views[view_index].recommendedImageRectHeight);
+		}
+
+		resolution_scaling.scale = glm::clamp(1.0f, resolution_scaling.min_scale, resolution_scaling.max_scale);
+		resolution_scaling.is_dirty = true;
+		resolution_scaling.ignored_timing_count = 0;
+	}
+
+	// Prepare the storage used by the frame loop. Everything that does not change
+	// between frames is filled up here once.
+	this->frame_state = {};
+	this->frame_state.view_count = view_count;
+
+	for (uint32_t view_index = 0; view_index < view_count; ++view_index)
+	{
+		const bool is_multi_pass = this->stereo_mode == StereoMode::MULTI_PASS;
+		const Swapchain& swapchain = this->swapchains[is_multi_pass ? view_index : 0];
+
+		this->frame_state.views[view_index].type = XrStructureType::XR_TYPE_VIEW;
+
+		XrCompositionLayerProjectionView& composition_layer_projection_view = this->frame_state.projection_views[view_index];
+		composition_layer_projection_view.type = XrStructureType::XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+		composition_layer_projection_view.subImage.swapchain = swapchain.swapchain;
+		composition_layer_projection_view.subImage.imageRect = swapchain.view_rects[is_multi_pass ? 0 : view_index];
+		composition_layer_projection_view.subImage.imageArrayIndex = swapchain.array_size > 1 ? view_index : 0;
+
+		// The depth of the view. The near and far planes are filled up each frame.
+		if (this->is_depth_submission_enabled)
+		{
+			XrCompositionLayerDepthInfoKHR& composition_layer_depth_info = this->frame_state.depth_infos[view_index];
+			composition_layer_depth_info.type = XrStructureType::XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR;
+			composition_layer_depth_info.subImage = composition_layer_projection_view.subImage;
+			composition_layer_depth_info.subImage.swapchain = swapchain.depth_swapchain;
+			composition_layer_depth_info.minDepth = 0.0f;
+			composition_layer_depth_info.maxDepth = 1.0f;
+			composition_layer_projection_view.next = &composition_layer_depth_info;
+		}
+	}
+
+	// 3D view
+	XrCompositionLayerProjection& composition_layer_projection = this->frame_state.projection_layer;
+	composition_layer_projection.type = XrStructureType::XR_TYPE_COMPOSITION_LAYER_PROJECTION;
+	composition_layer_projection.layerFlags = NULL_FLAG;
+	composition_layer_projection.space = this->space;
+	composition_layer_projection.viewCount = view_count;
+	composition_layer_projection.views = this->frame_state.projection_views.data();
+
+	// Only flag the session as running once it is fully set up, so that frames are never
+	//  rendered into a partially created session.
+	this->is_session_running_flag = true;
+
+	return true;
+}
+
+bool XrBridge::select_depth_swapchain_format()
+{
+	uint32_t format_count = 0;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainFormats(this->session, 0, &format_count, nullptr), "Failed to enumerate swapchain formats.");
+	std::vector<int64_t> formats(format_count);
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEnumerateSwapchainFormats(this->session, format_count, &format_count, formats.data()), "Failed to enumerate swapchain formats.");
+
+	const auto is_format_supported = [&formats] (const DepthFormat depth_format) {
+		return std::find(formats.begin(), formats.end(), static_cast<int64_t>(get_depth_format_internal_format(depth_format))) != formats.end();
+	};
+
+	if (is_format_supported(this->depth_format))
+	{
+		return true;
+	}
+
+	// Fall back to the first depth format that the runtime supports, in order of preference.
+	for (const DepthFormat depth_format : { DepthFormat::D24, DepthFormat::D32F, DepthFormat::D16 })
+	{
+		if (is_format_supported(depth_format))
+		{
+			XRBRIDGE_WARNING_OUT("The runtime does not support the chosen depth format for the depth swapchains, another one will be used.");
+			this->depth_format = depth_format;
+			return true;
+		}
+	}
+
+	XRBRIDGE_WARNING_OUT("The runtime does not support any depth format for the depth swapchains, the depth will not be submitted.");
+	this->is_depth_submission_enabled = false;
+
+	return true;
+}
+
+bool XrBridge::end_session()
+{
+	// Destroy swapchains.
+	for (const auto& swapchain : this->swapchains)
+	{
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrDestroySwapchain(swapchain.swapchain), "Failed to destroy swapchain.");
+
+		if (swapchain.depth_swapchain != XR_NULL_HANDLE)
+		{
+			RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrDestroySwapchain(swapchain.depth_swapchain), "Failed to destroy depth swapchain.");
+		}
+
+		if (swapchain.depth_texture != 0)
+		{
+			glDeleteTextures(1, &swapchain.depth_texture);
+		}
+	}
+
+	this->swapchains.clear();
+
+	// The images of the next session must be rendered before they can be reused.
+	this->frame_reuse.has_rendered_frame = false;
+
+	for (GLsync& fence : this->frames_in_flight.fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	LateLatching& late_latching = this->late_latching;
+
+	if (late_latching.copy_fence != nullptr)
+	{
+		glDeleteSync(late_latching.copy_fence);
+		late_latching.copy_fence = nullptr;
+	}
+
+	if (late_latching.mapped_staging_buffer != nullptr)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, late_latching.staging_buffer);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		late_latching.mapped_staging_buffer = nullptr;
+	}
+
+	if (late_latching.mapped_copied_slot_buffer != nullptr)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, late_latching.copied_slot_buffer);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		late_latching.mapped_copied_slot_buffer = nullptr;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	if (late_latching.staging_buffer != 0)
+	{
+		glDeleteBuffers(1, &late_latching.staging_buffer);
+		glDeleteBuffers(1, &late_latching.copied_slot_buffer);
+		late_latching.staging_buffer = 0;
+		late_latching.copied_slot_buffer = 0;
+	}
+
+	if (late_latching.copy_shader != 0)
+	{
+		glDeleteProgram(late_latching.copy_shader);
+		late_latching.copy_shader = 0;
+	}
+
+	if (this->stereo_matrices_buffer != 0)
+	{
+		glDeleteBuffers(1, &this->stereo_matrices_buffer);
+		this->stereo_matrices_buffer = 0;
+	}
+
+	if (this->visibility_mask_shader != 0)
+	{
+		glDeleteProgram(this->visibility_mask_shader);
+		glDeleteVertexArrays(1, &this->visibility_mask_vao);
+		glDeleteBuffers(1, &this->visibility_mask_vbo);
+		this->visibility_mask_shader = 0;
+		this->visibility_mask_vao = 0;
+		this->visibility_mask_vbo = 0;
+	}
+
+	this->visibility_masks = {};
+
+	for (Swapchain& peripheral_buffer : this->foveation.peripheral_buffers)
+	{
+		glDeleteTextures(1, &peripheral_buffer.depth_texture);
+	}
+
+	for (GLuint& color_texture : this->foveation.peripheral_color_textures)
+	{
+		if (color_texture != 0)
+		{
+			glDeleteTextures(1, &color_texture);
+			color_texture = 0;
+		}
+	}
+
+	this->foveation.peripheral_buffers.clear();
+
+	if (this->density_mask.vao != 0)
+	{
+		glDeleteProgram(this->density_mask.mask_shader);
+		glDeleteProgram(this->density_mask.reconstruction_shader);
+		glDeleteVertexArrays(1, &this->density_mask.vao);
+		this->density_mask.mask_shader = 0;
+		this->density_mask.reconstruction_shader = 0;
+		this->density_mask.vao = 0;
+	}
+
+	for (const GLuint scratch_texture : this->density_mask.scratch_textures)
+	{
+		glDeleteTextures(1, &scratch_texture);
+	}
+
+	this->density_mask.scratch_textures.clear();
+
+	if (this->frame_stats.gpu_queries[0][0] != 0)
+	{
+		for (std::array<GLuint, MAX_VIEWS>& gpu_queries : this->frame_stats.gpu_queries)
+		{
+			glDeleteQueries(MAX_VIEWS, gpu_queries.data());
+		}
+	}
+
+	this->frame_stats.gpu_queries = {};
+	this->frame_stats.is_gpu_query_pending = {};
+	this->frame_state = {};
+
+	// Destroy space.
+	if (this->space != XR_NULL_HANDLE)
+	{
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrDestroySpace(this->space), "Failed to destroy space.");
+		this->space = XR_NULL_HANDLE;
+	}
+
+	// End the session.
+	this->is_session_running_flag = false;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEndSession(this->session), "Failed to end session.");
+
+	return true;
+}
+
+bool XrBridge::submit_frame(FrameToken& frame, const render_function_t* render_function, const stereo_render_function_t* stereo_render_function)
+{
+	if (this->prepare_frame(frame, render_function != nullptr) == false)
+	{
+		return false;
+	}
+
+	if (this->frame_state.is_rendering_views)
+	{
+		const bool did_render = render_function != nullptr ?
+			this->render_multi_pass(*render_function) :
+			this->render_single_pass(*stereo_render_function);
+
+		if (did_render == false)
+		{
+			return false;
+		}
+	}
+
+	return this->finish_frame(frame);
+}
+
+bool XrBridge::prepare_frame(FrameToken& frame, const bool is_multi_pass)
+{
+	XRBRIDGE_CHECK_RENDERING(true);
+
+	XRBRIDGE_CHECK_INITIALIZED(false);
+
+	XRBRIDGE_CHECK_DEINITIALIZED(true);
+
+	if (frame.is_begun == false)
+	{
+		XRBRIDGE_ERROR_OUT("The frame must be begun with begin_frame() before being ended!");
+		return false;
+	}
+
+	if ((this->stereo_mode == StereoMode::MULTI_PASS) != is_multi_pass)
+	{
+		XRBRIDGE_ERROR_OUT("Use render() and end_frame() with StereoMode::MULTI_PASS, render_stereo() and end_frame_stereo() otherwise!");
+		return false;
+	}
+
+	// A token can only be ended once.
+	frame.is_waited = false;
+	frame.is_begun = false;
+
+	this->is_currently_rendering_flag = true;
+
+	// NOTE: Nothing in here should allocate memory. All of the storage used to build
+	// the frame is pre-allocated in `frame_state` by `begin_session()`.
+	FrameState& frame_state = this->frame_state;
+
+	const bool is_session_active =
+		this->session_state == XrSessionState::XR_SESSION_STATE_SYNCHRONIZED ||
+		this->session_state == XrSessionState::XR_SESSION_STATE_VISIBLE ||
+		this->session_state == XrSessionState::XR_SESSION_STATE_FOCUSED;
+
+	frame_state.has_projection_layer = false;
+	frame_state.is_rendering_views = false;
+	frame_state.is_single_eye = this->is_watchdog_enabled && this->watchdog.level >= DegradationLevel::SINGLE_EYE && this->is_degradation_level_available(DegradationLevel::SINGLE_EYE);
+
+	if (this->is_resolution_scaling_enabled)
+	{
+		this->resolution_scaling.display_period = static_cast<float>(frame.predicted_display_period) / 1'000'000.0f;
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->frame_stats.frame_timings = {};
+		this->frame_stats.frame_timings[static_cast<size_t>(Timing::WAIT_FRAME)] = frame.wait_frame_time;
+		this->frame_stats.frame_timings[static_cast<size_t>(Timing::BEGIN_FRAME)] = frame.begin_frame_time;
+		this->collect_gpu_timers();
+	}
+
+	if (is_session_active == false || frame.should_render == false)
+	{
+		return true;
+	}
+
+	if (this->is_resolution_scaling_enabled && this->resolution_scaling.is_dirty)
+	{
+		this->apply_resolution_scale();
+
+		// The images must be rendered again at the new resolution.
+		this->frame_reuse.has_rendered_frame = false;
+	}
+
+	if (this->is_just_in_time_enabled)
+	{
+		this->sleep_until_just_in_time(frame);
+	}
+
+	// Wait for the GPU before sampling the head pose, so that the wait does not add latency.
+	if (this->is_frames_in_flight_enabled && this->wait_frames_in_flight() == false)
+	{
+		return false;
+	}
+
+	if (this->locate_views(frame) == false)
+	{
+		return false;
+	}
+
+	frame_state.has_projection_layer = true;
+
+	const bool is_reusing_frame = this->frame_reuse.has_rendered_frame && (
+		(this->is_frame_reuse_enabled && this->can_reuse_frame()) ||
+		(this->is_watchdog_enabled && this->watchdog.level == DegradationLevel::REUSED_FRAME));
+
+	if (is_reusing_frame)
+	{
+		// No image is acquired, so the runtime displays the last released image of each
+		//  swapchain. Submit it with the views it was rendered with, so that it is reprojected.
+		for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+		{
+			frame_state.projection_views[view_index].pose = this->frame_reuse.rendered_views[view_index].pose;
+			frame_state.projection_views[view_index].fov = this->frame_reuse.rendered_views[view_index].fov;
+		}
+
+		if (frame_state.is_single_eye)
+		{
+			this->share_left_eye();
+		}
+
+		++this->frame_reuse.reused_frame_count;
+
+		return true;
+	}
+
+	if (frame_state.is_single_eye)
+	{
+		this->share_left_eye();
+	}
+
+	if (this->is_foveation_enabled && this->update_foveation(frame) == false)
+	{
+		return false;
+	}
+
+	if (this->is_late_latching_enabled && this->write_late_latched_matrices() == false)
+	{
+		return false;
+	}
+
+	// Call the user-defined pre-pass function, once for both eyes.
+	if (this->pre_pass_function)
+	{
+		this->compute_stereo_frustum();
+
+		if (this->is_late_latching_enabled)
+		{
+			this->bind_late_latched_matrices();
+		}
+
+		const std::chrono::steady_clock::time_point pre_pass_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+		this->pre_pass_function(frame_state.matrices, frame_state.frustum, frame.predicted_display_time);
+
+		if (this->is_frame_stats_enabled)
+		{
+			this->add_frame_timing(Timing::RENDER_FUNCTION, pre_pass_start);
+		}
+	}
+
+	// Acquire the images of every swapchain up front. Each one is only waited right before
+	//  being rendered, so the wait for an eye overlaps with the rendering of the previous one.
+	const size_t swapchain_count = frame_state.is_single_eye ? 1 : this->swapchains.size();
+	for (size_t swapchain_index = 0; swapchain_index < swapchain_count; ++swapchain_index)
+	{
+		if (this->acquire_swapchain_images(this->swapchains[swapchain_index], frame_state.image_indices[swapchain_index]) == false)
+		{
+			return false;
+		}
+	}
+
+	frame_state.is_rendering_views = true;
+
+	return true;
+}
+
+bool XrBridge::finish_frame(FrameToken& frame)
+{
+	FrameState& frame_state = this->frame_state;
+
+	uint32_t layer_count = 0;
+
+	if (frame_state.is_rendering_views)
+	{
+		if (this->is_late_latching_enabled && this->late_latch_views(frame) == false)
+		{
+			return false;
+		}
+
+		// Mark the end of the frame, so that the next frames can wait for it.
+		if (this->is_frames_in_flight_enabled)
+		{
+			FramesInFlight& frames_in_flight = this->frames_in_flight;
+			frames_in_flight.fences[frames_in_flight.next_fence] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			frames_in_flight.next_fence = (frames_in_flight.next_fence + 1) % frames_in_flight.max_frames_in_flight;
+		}
+
+		// Release the images of all of the swapchains together.
+		const size_t swapchain_count = frame_state.is_single_eye ? 1 : this->swapchains.size();
+		for (size_t swapchain_index = 0; swapchain_index < swapchain_count; ++swapchain_index)
+		{
+			if (this->release_swapchain_images(this->swapchains[swapchain_index]) == false)
+			{
+				return false;
+			}
+		}
+
+		if (this->is_frame_reuse_enabled || this->is_watchdog_enabled)
+		{
+			this->frame_reuse.rendered_views = frame_state.views;
+			this->frame_reuse.has_rendered_frame = true;
+		}
+	}
+
+	if (frame_state.has_projection_layer)
+	{
+		// 3D view
+		frame_state.layers[layer_count++] = reinterpret_cast<const XrCompositionLayerBaseHeader*>(&frame_state.projection_layer);
+	}
+
+	XrFrameEndInfo frame_end_info = {};
+	frame_end_info.type = XrStructureType::XR_TYPE_FRAME_END_INFO;
+	frame_end_info.displayTime = frame.predicted_display_time;
+	// NOTE: This is the blend mode. In the case of AR, choose something like ALPHA or ADDITTIVE to mix the virtual and real world.
+	frame_end_info.environmentBlendMode = XrEnvironmentBlendMode::XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+	frame_end_info.layerCount = layer_count;
+	frame_end_info.layers = frame_state.layers.data();
+
+	const std::chrono::steady_clock::time_point end_frame_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrEndFrame(this->session, &frame_end_info), "Failed to end frame.");
+
+	if (this->is_frame_stats_enabled)
+	{
+		FrameStatsState& frame_stats = this->frame_stats;
+
+		this->add_frame_timing(Timing::END_FRAME, end_frame_start);
+
+		this->record_timing(Timing::WAIT_FRAME, frame_stats.frame_timings[static_cast<size_t>(Timing::WAIT_FRAME)]);
+		this->record_timing(Timing::BEGIN_FRAME, frame_stats.frame_timings[static_cast<size_t>(Timing::BEGIN_FRAME)]);
+		this->record_timing(Timing::END_FRAME, frame_stats.frame_timings[static_cast<size_t>(Timing::END_FRAME)]);
+
+		// The other timings only exist when the views were rendered.
+		if (frame_state.is_rendering_views)
+		{
+			this->record_timing(Timing::ACQUIRE_IMAGE, frame_stats.frame_timings[static_cast<size_t>(Timing::ACQUIRE_IMAGE)]);
+			this->record_timing(Timing::WAIT_IMAGE, frame_stats.frame_timings[static_cast<size_t>(Timing::WAIT_IMAGE)]);
+			this->record_timing(Timing::WAIT_IMAGE_LEFT, frame_stats.frame_timings[static_cast<size_t>(Timing::WAIT_IMAGE_LEFT)]);
+			if (this->swapchains.size() > 1 && frame_state.is_single_eye == false)
+			{
+				this->record_timing(Timing::WAIT_IMAGE_RIGHT, frame_stats.frame_timings[static_cast<size_t>(Timing::WAIT_IMAGE_RIGHT)]);
+			}
+			this->record_timing(Timing::RENDER_FUNCTION, frame_stats.frame_timings[static_cast<size_t>(Timing::RENDER_FUNCTION)]);
+			this->record_timing(Timing::POSE_TO_END_FRAME, std::chrono::duration<float, std::milli>(end_frame_start - frame_stats.pose_time).count());
+			if (this->is_frames_in_flight_enabled)
+			{
+				this->record_timing(Timing::FRAMES_IN_FLIGHT_WAIT, frame_stats.frame_timings[static_cast<size_t>(Timing::FRAMES_IN_FLIGHT_WAIT)]);
+			}
+			if (this->is_render_thread_enabled && this->render_thread.packet.data != nullptr)
+			{
+				this->record_timing(Timing::FRAME_PACKET_AGE, std::chrono::duration<float, std::milli>(end_frame_start - this->render_thread.packet.push_time).count());
+			}
+			if (this->is_just_in_time_enabled)
+			{
+				this->record_timing(Timing::JUST_IN_TIME_SLEEP, frame_stats.frame_timings[static_cast<size_t>(Timing::JUST_IN_TIME_SLEEP)]);
+			}
+			frame_stats.gpu_query_frame = (frame_stats.gpu_query_frame + 1) % GPU_TIMER_LATENCY;
+		}
+
+		// If the gap between the display times of two frames is larger than a display
+		//  period, the frames in between were missed.
+		if (frame_stats.last_display_time != 0 && frame.predicted_display_period > 0)
+		{
+			const XrDuration display_time_delta = frame.predicted_display_time - frame_stats.last_display_time;
+			const XrDuration skipped_periods = (display_time_delta + frame.predicted_display_period / 2) / frame.predicted_display_period;
+			if (skipped_periods > 1)
+			{
+				frame_stats.missed_frame_count += static_cast<uint64_t>(skipped_periods - 1);
+			}
+		}
+
+		frame_stats.last_display_time = frame.predicted_display_time;
+		++frame_stats.frame_count;
+	}
+
+	if (this->is_just_in_time_enabled)
+	{
+		this->update_just_in_time();
+	}
+
+	if (this->is_watchdog_enabled)
+	{
+		this->update_watchdog(frame);
+	}
+
+	if (this->is_slack_tasks_enabled)
+	{
+		this->run_slack_tasks(frame);
+	}
+
+	// The scene must be marked as clean again for the next frame.
+	this->frame_reuse.is_scene_clean = false;
+
+	this->is_currently_rendering_flag = false;
+
+	return true;
+}
+
+void XrBridge::sleep_until_just_in_time(const FrameToken& frame)
+{
+	JustInTime& just_in_time = this->just_in_time;
+
+	// The frame must be submitted within a display period of the end of `xrWaitFrame`.
+	const float display_period = static_cast<float>(frame.predicted_display_period) / 1'000'000.0f;
+	const float delay = display_period - just_in_time.cpu_cost - just_in_time.gpu_cost - just_in_time.margin;
+
+	// Do not sleep until the GPU cost is known.
+	if (just_in_time.gpu_cost > 0.0f && delay > 0.0f)
+	{
+		std::this_thread::sleep_until(frame.wait_frame_end + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(delay)));
+	}
+
+	just_in_time.frame_start = std::chrono::steady_clock::now();
+
+	this->frame_stats.frame_timings[static_cast<size_t>(Timing::JUST_IN_TIME_SLEEP)] = std::chrono::duration<float, std::milli>(just_in_time.frame_start - frame.wait_frame_end).count();
+}
+
+void XrBridge::run_slack_tasks(const FrameToken& frame)
+{
+	// The next call to `xrWaitFrame` returns about a display period after the last one.
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::chrono::steady_clock::time_point deadline = frame.wait_frame_end + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<float, std::milli>(static_cast<float>(frame.predicted_display_period) / 1'000'000.0f - this->slack_reserve));
+
+	// Run each task at most once per frame. The tasks added meanwhile wait for the next frame.
+	size_t task_count = this->slack_tasks.size();
+
+	while (task_count > 0 && std::chrono::steady_clock::now() < deadline)
+	{
+		slack_task_t task = std::move(this->slack_tasks.front());
+		this->slack_tasks.pop_front();
+		--task_count;
+
+		if (task() == false)
+		{
+			this->slack_tasks.push_back(std::move(task));
+		}
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->record_timing(Timing::SLACK_TASKS, get_elapsed_milliseconds(start));
+	}
+}
+
+bool XrBridge::is_degradation_level_available(const DegradationLevel level) const
+{
+	if (level > this->watchdog.max_level)
+	{
+		return false;
+	}
+
+	switch (level)
+	{
+	case DegradationLevel::REDUCED_RESOLUTION:
+		return this->is_resolution_scaling_enabled;
+	case DegradationLevel::SINGLE_EYE:
+		return this->stereo_mode == StereoMode::MULTI_PASS && this->swapchains.size() > 1 && this->is_foveation_enabled == false && this->is_late_latching_enabled == false;
+	default:
+		return true;
+	}
+}
+
+void XrBridge::update_watchdog(const FrameToken& frame)
+{
+	Watchdog& watchdog = this->watchdog;
+
+	const float display_period = static_cast<float>(frame.predicted_display_period) / 1'000'000.0f;
+
+	if (display_period <= 0.0f)
+	{
+		return;
+	}
+
+	if (this->frame_state.is_rendering_views)
+	{
+		const float render_function_time = this->frame_stats.frame_timings[static_cast<size_t>(Timing::RENDER_FUNCTION)];
+
+		if (render_function_time > display_period * watchdog.overrun_threshold)
+		{
+			++watchdog.overrun_count;
+			++watchdog.overrun_frame_count;
+			watchdog.headroom_frame_count = 0;
+		}
+		else if (render_function_time < display_period * watchdog.recovery_threshold)
+		{
+			watchdog.overrun_frame_count = 0;
+			++watchdog.headroom_frame_count;
+		}
+		else
+		{
+			watchdog.overrun_frame_count = 0;
+			watchdog.headroom_frame_count = 0;
+		}
+	}
+	else if (watchdog.level == DegradationLevel::REUSED_FRAME)
+	{
+		// Nothing is measured while the frames are reused, so try to render again after a while.
+		++watchdog.headroom_frame_count;
+	}
+	else
+	{
+		return;
+	}
+
+	int32_t step = 0;
+
+	if (watchdog.overrun_frame_count >= XRBRIDGE_CONFIG_WATCHDOG_OVERRUN_FRAMES)
+	{
+		step = 1;
+	}
+	else if (watchdog.headroom_frame_count >= XRBRIDGE_CONFIG_WATCHDOG_RECOVERY_FRAMES)
+	{
+		step = -1;
+	}
+	else
+	{
+		return;
+	}
+
+	watchdog.overrun_frame_count = 0;
+	watchdog.headroom_frame_count = 0;
+
+	// Move to the next available step in that direction, if there is one.
+	for (int32_t level = static_cast<int32_t>(watchdog.level) + step; level >= static_cast<int32_t>(DegradationLevel::NONE) && level <= static_cast<int32_t>(DegradationLevel::REUSED_FRAME); level += step)
+	{
+		if (this->is_degradation_level_available(static_cast<DegradationLevel>(level)))
+		{
+			this->set_degradation_level(static_cast<DegradationLevel>(level));
+			break;
+		}
+	}
+}
+
+void XrBridge::set_degradation_level(const DegradationLevel level)
+{
+	Watchdog& watchdog = this->watchdog;
+	FrameState& frame_state = this->frame_state;
+
+	XRBRIDGE_DEBUG_OUT("The overrun watchdog moves from degradation level " << static_cast<int32_t>(watchdog.level) << " to " << static_cast<int32_t>(level) << ".");
+
+	if (level >= DegradationLevel::REDUCED_RESOLUTION && this->is_resolution_scaling_enabled)
+	{
+		ResolutionScaling& resolution_scaling = this->resolution_scaling;
+
+		if (resolution_scaling.scale != resolution_scaling.min_scale)
+		{
+			resolution_scaling.scale = resolution_scaling.min_scale;
+			resolution_scaling.is_dirty = true;
+			resolution_scaling.ignored_timing_count = GPU_TIMER_LATENCY;
+		}
+	}
+
+	// Point the RIGHT eye back to its own swapchain. Its last image is stale, so it cannot be reused.
+	if (watchdog.level >= DegradationLevel::SINGLE_EYE && level < DegradationLevel::SINGLE_EYE && this->is_degradation_level_available(DegradationLevel::SINGLE_EYE))
+	{
+		const Swapchain& swapchain = this->swapchains[1];
+
+		XrSwapchainSubImage& sub_image = frame_state.projection_views[1].subImage;
+		sub_image.swapchain = swapchain.swapchain;
+		sub_image.imageRect = swapchain.view_rects[0];
+		sub_image.imageArrayIndex = 0;
+
+		frame_state.depth_infos[1].subImage = sub_image;
+		frame_state.depth_infos[1].subImage.swapchain = swapchain.depth_swapchain;
+
+		if (this->is_resolution_scaling_enabled)
+		{
+			this->resolution_scaling.is_dirty = true;
+		}
+
+		this->frame_reuse.has_rendered_frame = false;
+	}
+
+	watchdog.level = level;
+}
+
+void XrBridge::share_left_eye()
+{
+	FrameState& frame_state = this->frame_state;
+
+	// The compositor reprojects the image of the LEFT eye to the pose of the RIGHT eye.
+	frame_state.projection_views[1].subImage = frame_state.projection_views[0].subImage;
+	frame_state.projection_views[1].pose = frame_state.projection_views[0].pose;
+	frame_state.projection_views[1].fov = frame_state.projection_views[0].fov;
+	frame_state.depth_infos[1].subImage = frame_state.depth_infos[0].subImage;
+}
+
+void XrBridge::update_just_in_time()
+{
+	JustInTime& just_in_time = this->just_in_time;
+
+	// Only the frames that were rendered tell something about the cost.
+	if (this->frame_state.is_rendering_views)
+	{
+		const float cpu_cost = get_elapsed_milliseconds(just_in_time.frame_start);
+		just_in_time.cpu_cost = glm::max(cpu_cost, glm::mix(just_in_time.cpu_cost, cpu_cost, 0.05f));
+	}
+
+	// Back off quickly when a frame is missed, and get closer again slowly.
+	if (this->frame_stats.missed_frame_count != just_in_time.missed_frame_count)
+	{
+		just_in_time.margin = glm::min(just_in_time.margin * 2.0f, just_in_time.max_margin);
+		just_in_time.missed_frame_count = this->frame_stats.missed_frame_count;
+	}
+	else
+	{
+		just_in_time.margin = glm::max(just_in_time.margin * 0.99f, just_in_time.min_margin);
+	}
+}
+
+bool XrBridge::locate_views(const FrameToken& frame)
+{
+	FrameState& frame_state = this->frame_state;
+
+	XrViewState view_state = {};
+	view_state.type = XrStructureType::XR_TYPE_VIEW_STATE;
+	XrViewLocateInfo view_locate_info = {};
+	view_locate_info.type = XrStructureType::XR_TYPE_VIEW_LOCATE_INFO;
+	view_locate_info.viewConfigurationType = XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	view_locate_info.displayTime = frame.predicted_display_time;
+	view_locate_info.space = this->space;
+
+	// The number of views is known since the beginning of the session, so we can locate them in one call.
+	uint32_t view_count = 0;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrLocateViews(this->session, &view_locate_info, &view_state, frame_state.view_count, &view_count, frame_state.views.data()), "Failed to locate views.");
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->frame_stats.pose_time = std::chrono::steady_clock::now();
+	}
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		const XrView& current_view = frame_state.views[view_index];
+
+		// The static parts of the projection view (type, swapchain, image rect) are set up in `begin_session()`.
+		XrCompositionLayerProjectionView& composition_layer_projection_view = frame_state.projection_views[view_index];
+		composition_layer_projection_view.pose = current_view.pose;
+		composition_layer_projection_view.fov = current_view.fov;
+
+		XrCompositionLayerDepthInfoKHR& composition_layer_depth_info = frame_state.depth_infos[view_index];
+		composition_layer_depth_info.nearZ = this->near_clipping_plane;
+		composition_layer_depth_info.farZ = this->far_clipping_plane;
+
+		// Create the projection matrix
+		const glm::mat4 projection_matrix = create_projection_matrix(
+			current_view.fov,
+			this->near_clipping_plane,
+			this->far_clipping_plane);
+
+		// Create the view matrix
+		const glm::mat4 view_matrix = create_view_matrix(current_view.pose);
+
+		frame_state.matrices.projection_matrices[view_index] = projection_matrix;
+		frame_state.matrices.view_matrices[view_index] = view_matrix;
+		frame_state.inverse_view_matrices[view_index] = glm::inverse(view_matrix);
+		frame_state.matrices.view_projection_matrices[view_index] = projection_matrix * frame_state.inverse_view_matrices[view_index];
+
+		if (this->is_visibility_mask_enabled)
+		{
+			VisibilityMask& visibility_mask = this->visibility_masks[view_index];
+
+			// The mask is defined on the z = -1 plane, where the tangents of the fov angles live.
+			if (visibility_mask.is_culled_ratio_dirty)
+			{
+				const float fov_area = (std::tan(current_view.fov.angleRight) - std::tan(current_view.fov.angleLeft)) * (std::tan(current_view.fov.angleUp) - std::tan(current_view.fov.angleDown));
+				float hidden_area = 0.0f;
+
+				for (size_t vertex_index = 0; vertex_index + 2 < visibility_mask.hidden_triangles.size(); vertex_index += 3)
+				{
+					const XrVector2f& a = visibility_mask.hidden_triangles[vertex_index];
+					const XrVector2f& b = visibility_mask.hidden_triangles[vertex_index + 1];
+					const XrVector2f& c = visibility_mask.hidden_triangles[vertex_index + 2];
+					hidden_area += std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) * 0.5f;
+				}
+
+				visibility_mask.culled_ratio = fov_area > 0.0f ? glm::clamp(hidden_area / fov_area, 0.0f, 1.0f) : 0.0f;
+				visibility_mask.is_culled_ratio_dirty = false;
+
+				XRBRIDGE_DEBUG_OUT("The visibility mask culls " << (visibility_mask.culled_ratio * 100.0f) << "% of the pixels of view " << view_index << ".");
+			}
+
+			// Project the bounding box of the visible area to get the scissor rectangle.
+			// On the z = -1 plane, w is always 1, so there is no need for the perspective division.
+			const XrRect2Di& view_rect = composition_layer_projection_view.subImage.imageRect;
+			const glm::vec4 visible_min = projection_matrix * glm::vec4(visibility_mask.visible_min.x, visibility_mask.visible_min.y, -1.0f, 1.0f);
+			const glm::vec4 visible_max = projection_matrix * glm::vec4(visibility_mask.visible_max.x, visibility_mask.visible_max.y, -1.0f, 1.0f);
+			const int32_t min_x = static_cast<int32_t>(std::floor(glm::clamp(visible_min.x * 0.5f + 0.5f, 0.0f, 1.0f) * view_rect.extent.width));
+			const int32_t min_y = static_cast<int32_t>(std::floor(glm::clamp(visible_min.y * 0.5f + 0.5f, 0.0f, 1.0f) * view_rect.extent.height));
+			const int32_t max_x = static_cast<int32_t>(std::ceil(glm::clamp(visible_max.x * 0.5f + 0.5f, 0.0f, 1.0f) * view_rect.extent.width));
+			const int32_t max_y = static_cast<int32_t>(std::ceil(glm::clamp(visible_max.y * 0.5f + 0.5f, 0.0f, 1.0f) * view_rect.extent.height));
+
+			XrRect2Di& scissor_rect = frame_state.scissor_rects[view_index];
+			scissor_rect.offset.x = view_rect.offset.x + min_x;
+			scissor_rect.offset.y = view_rect.offset.y + min_y;
+			scissor_rect.extent.width = max_x - min_x;
+			scissor_rect.extent.height = max_y - min_y;
+		}
+	}
+
+	return true;
+}
+
+void XrBridge::compute_stereo_frustum()
+{
+	FrameState& frame_state = this->frame_state;
+
+	const XrView& first_view = frame_state.views[0];
+	const XrView& last_view = frame_state.views[frame_state.view_count - 1];
+
+	// The frustum looks halfway between the views.
+	const glm::quat first_orientation = glm::quat(first_view.pose.orientation.w, first_view.pose.orientation.x, first_view.pose.orientation.y, first_view.pose.orientation.z);
+	const glm::quat last_orientation = glm::quat(last_view.pose.orientation.w, last_view.pose.orientation.x, last_view.pose.orientation.y, last_view.pose.orientation.z);
+	const glm::quat orientation = glm::slerp(first_orientation, last_orientation, 0.5f);
+	const glm::vec3 center = (XRV_TO_GV(first_view.pose.position) + XRV_TO_GV(last_view.pose.position)) * 0.5f;
+	const glm::quat inverse_orientation = glm::inverse(orientation);
+
+	// The tangents of the union of the views, in the space of the frustum. The corners of the
+	//  views are enough, since the views may be rotated with respect to each other (canted displays).
+	float tan_left = 0.0f;
+	float tan_right = 0.0f;
+	float tan_down = 0.0f;
+	float tan_up = 0.0f;
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		const XrView& view = frame_state.views[view_index];
+		const glm::quat view_orientation = glm::quat(view.pose.orientation.w, view.pose.orientation.x, view.pose.orientation.y, view.pose.orientation.z);
+		const glm::quat relative_orientation = inverse_orientation * view_orientation;
+
+		const float view_tangents_x[2] = { std::tan(view.fov.angleLeft), std::tan(view.fov.angleRight) };
+		const float view_tangents_y[2] = { std::tan(view.fov.angleDown), std::tan(view.fov.angleUp) };
+
+		for (const float view_tangent_x : view_tangents_x)
+		{
+			for (const float view_tangent_y : view_tangents_y)
+			{
+				const glm::vec3 corner = relative_orientation * glm::vec3(view_tangent_x, view_tangent_y, -1.0f);
+				tan_left = glm::min(tan_left, corner.x / -corner.z);
+				tan_right = glm::max(tan_right, corner.x / -corner.z);
+				tan_down = glm::min(tan_down, corner.y / -corner.z);
+				tan_up = glm::max(tan_up, corner.y / -corner.z);
+			}
+		}
+	}
+
+	// Move the apex back until every view is inside of the frustum.
+	float distance = 0.0f;
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		const glm::vec3 position = inverse_orientation * (XRV_TO_GV(frame_state.views[view_index].pose.position) - center);
+
+		if (tan_left < 0.0f)
+		{
+			distance = glm::max(distance, position.z + position.x / tan_left);
+		}
+		if (tan_right > 0.0f)
+		{
+			distance = glm::max(distance, position.z + position.x / tan_right);
+		}
+		if (tan_down < 0.0f)
+		{
+			distance = glm::max(distance, position.z + position.y / tan_down);
+		}
+		if (tan_up > 0.0f)
+		{
+			distance = glm::max(distance, position.z + position.y / tan_up);
+		}
+	}
+
+	XrFovf fov = {};
+	fov.angleLeft = std::atan(tan_left);
+	fov.angleRight = std::atan(tan_right);
+	fov.angleDown = std::atan(tan_down);
+	fov.angleUp = std::atan(tan_up);
+
+	const glm::mat4 rotation_matrix = glm::mat4_cast(orientation);
+	const glm::mat4 translation_matrix = glm::translate(glm::mat4(1.0f), center + orientation * glm::vec3(0.0f, 0.0f, distance));
+
+	StereoFrustum& frustum = frame_state.frustum;
+	frustum.projection_matrix = create_projection_matrix(fov, this->near_clipping_plane, this->far_clipping_plane + distance);
+	frustum.view_matrix = translation_matrix * rotation_matrix;
+	frustum.view_projection_matrix = frustum.projection_matrix * glm::inverse(frustum.view_matrix);
+}
+
+bool XrBridge::wait_frames_in_flight()
+{
+	FramesInFlight& frames_in_flight = this->frames_in_flight;
+
+	// The entry that is about to be reused holds the fence of the oldest frame in flight.
+	GLsync& fence = frames_in_flight.fences[frames_in_flight.next_fence];
+	if (fence == nullptr)
+	{
+		return true;
+	}
+
+	const std::chrono::steady_clock::time_point wait_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+	// Flush the commands on the first try, otherwise the fence might never be signaled.
+	GLenum wait_result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, XRBRIDGE_CONFIG_FRAMES_IN_FLIGHT_WAIT_TIMEOUT);
+	for (uint32_t timeout_count = 1; wait_result == GL_TIMEOUT_EXPIRED && timeout_count < XRBRIDGE_CONFIG_FRAMES_IN_FLIGHT_WAIT_MAX_TIMEOUTS; ++timeout_count)
+	{
+		wait_result = glClientWaitSync(fence, 0, XRBRIDGE_CONFIG_FRAMES_IN_FLIGHT_WAIT_TIMEOUT);
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+
+	if (wait_result == GL_WAIT_FAILED)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to wait for the frames in flight.");
+		return false;
+	}
+
+	if (wait_result == GL_TIMEOUT_EXPIRED)
+	{
+		XRBRIDGE_ERROR_OUT("The GPU has not finished the frames in flight in time.");
+		return false;
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->add_frame_timing(Timing::FRAMES_IN_FLIGHT_WAIT, wait_start);
+	}
+
+	return true;
+}
+
+bool XrBridge::write_late_latched_matrices()
+{
+	LateLatching& late_latching = this->late_latching;
+
+	// The copy of the previous frame must have read the slots before they are written again.
+	if (late_latching.copy_fence != nullptr && this->wait_late_latching_copy() == false)
+	{
+		return false;
+	}
+
+	const uint32_t published_slot = LATE_LATCHING_ORIGINAL_SLOT;
+	std::memcpy(late_latching.mapped_staging_buffer + LATE_LATCHING_SLOT_OFFSET + published_slot * sizeof(StereoMatrices), &this->frame_state.matrices, sizeof(StereoMatrices));
+	std::memcpy(late_latching.mapped_staging_buffer, &published_slot, sizeof(published_slot));
+
+	// Copy the published slot before any command of the frame. The copy reads the index when
+	//  it executes, so the late latched matrices are used if they are published before that.
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, late_latching.staging_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, this->stereo_matrices_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, late_latching.copied_slot_buffer);
+	glUseProgram(late_latching.copy_shader);
+	glDispatchCompute(1, 1, 1);
+	glUseProgram(0);
+
+	for (GLuint binding = 0; binding < 3; ++binding)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+	}
+
+	glMemoryBarrier(GL_UNIFORM_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+	late_latching.copy_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	return true;
+}
+
+bool XrBridge::wait_late_latching_copy()
+{
+	LateLatching& late_latching = this->late_latching;
+
+	// Flush the commands, otherwise the fence might never be signaled.
+	const GLenum wait_result = glClientWaitSync(late_latching.copy_fence, GL_SYNC_FLUSH_COMMANDS_BIT, XRBRIDGE_CONFIG_LATE_LATCHING_WAIT_TIMEOUT);
+	glDeleteSync(late_latching.copy_fence);
+	late_latching.copy_fence = nullptr;
+
+	if (wait_result == GL_WAIT_FAILED)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to wait for the late latching copy.");
+		return false;
+	}
+
+	if (wait_result == GL_TIMEOUT_EXPIRED)
+	{
+		XRBRIDGE_ERROR_OUT("The GPU has not copied the late latched matrices in time.");
+		return false;
+	}
+
+	return true;
+}
+
+void XrBridge::bind_late_latched_matrices() const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, STEREO_MATRICES_BINDING, this->stereo_matrices_buffer);
+}
+
+bool XrBridge::late_latch_views(const FrameToken& frame)
+{
+	LateLatching& late_latching = this->late_latching;
+	FrameState& frame_state = this->frame_state;
+
+	XrViewState view_state = {};
+	view_state.type = XrStructureType::XR_TYPE_VIEW_STATE;
+	XrViewLocateInfo view_locate_info = {};
+	view_locate_info.type = XrStructureType::XR_TYPE_VIEW_LOCATE_INFO;
+	view_locate_info.viewConfigurationType = XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	view_locate_info.displayTime = frame.predicted_display_time;
+	view_locate_info.space = this->space;
+
+	std::array<XrView, MAX_VIEWS> views = {};
+	for (XrView& view : views)
+	{
+		view.type = XrStructureType::XR_TYPE_VIEW;
+	}
+
+	uint32_t view_count = 0;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrLocateViews(this->session, &view_locate_info, &view_state, frame_state.view_count, &view_count, views.data()), "Failed to locate views.");
+
+	// Keep the old poses if the tracking has been lost in the meantime. The copy is waited
+	//  before the slots are written again, at the beginning of the next frame.
+	const XrViewStateFlags required_flags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT;
+	if ((view_state.viewStateFlags & required_flags) != required_flags)
+	{
+		return true;
+	}
+
+	// Only the poses are updated. The projection matrices, and everything derived
+	//  from the field of view, must stay the same as the ones used for rendering.
+	StereoMatrices matrices = frame_state.matrices;
+	std::array<glm::mat4, MAX_VIEWS> inverse_view_matrices = {};
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		matrices.view_matrices[view_index] = create_view_matrix(views[view_index].pose);
+		inverse_view_matrices[view_index] = glm::inverse(matrices.view_matrices[view_index]);
+		matrices.view_projection_matrices[view_index] = matrices.projection_matrices[view_index] * inverse_view_matrices[view_index];
+	}
+
+	const std::chrono::steady_clock::time_point pose_time = std::chrono::steady_clock::now();
+
+	// Publish the index only once the slot has been written. The full fence also orders the
+	//  write-combined stores to the mapping.
+	const uint32_t published_slot = LATE_LATCHING_LATCHED_SLOT;
+	std::memcpy(late_latching.mapped_staging_buffer + LATE_LATCHING_SLOT_OFFSET + published_slot * sizeof(StereoMatrices), &matrices, sizeof(StereoMatrices));
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::memcpy(late_latching.mapped_staging_buffer, &published_slot, sizeof(published_slot));
+
+	if (this->wait_late_latching_copy() == false)
+	{
+		return false;
+	}
+
+	// The GPU has already started the frame with the old matrices, so submit it with the old poses.
+	if (*late_latching.mapped_copied_slot_buffer != published_slot)
+	{
+		return true;
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->frame_stats.pose_time = pose_time;
+	}
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		frame_state.views[view_index].pose = views[view_index].pose;
+		frame_state.projection_views[view_index].pose = views[view_index].pose;
+		frame_state.inverse_view_matrices[view_index] = inverse_view_matrices[view_index];
+	}
+
+	frame_state.matrices = matrices;
+
+	return true;
+}
+
+bool XrBridge::can_reuse_frame() const
+{
+	const FrameReuse& frame_reuse = this->frame_reuse;
+
+	if (frame_reuse.is_scene_clean == false || frame_reuse.has_rendered_frame == false)
+	{
+		return false;
+	}
+
+	for (uint32_t view_index = 0; view_index < this->frame_state.view_count; ++view_index)
+	{
+		const XrView& current_view = this->frame_state.views[view_index];
+		const XrView& rendered_view = frame_reuse.rendered_views[view_index];
+
+		const glm::quat current_orientation = glm::quat(current_view.pose.orientation.w, current_view.pose.orientation.x, current_view.pose.orientation.y, current_view.pose.orientation.z);
+		const glm::quat rendered_orientation = glm::quat(rendered_view.pose.orientation.w, rendered_view.pose.orientation.x, rendered_view.pose.orientation.y, rendered_view.pose.orientation.z);
+
+		// The angle between the two orientations.
+		const float cos_half_angle = glm::min(std::abs(glm::dot(current_orientation, rendered_orientation)), 1.0f);
+		const float angle = 2.0f * std::acos(cos_half_angle);
+
+		const float fov_difference = glm::max(
+			glm::max(std::abs(current_view.fov.angleLeft - rendered_view.fov.angleLeft), std::abs(current_view.fov.angleRight - rendered_view.fov.angleRight)),
+			glm::max(std::abs(current_view.fov.angleDown - rendered_view.fov.angleDown), std::abs(current_view.fov.angleUp - rendered_view.fov.angleUp)));
+
+		if (glm::distance(XRV_TO_GV(current_view.pose.position), XRV_TO_GV(rendered_view.pose.position)) > frame_reuse.position_epsilon ||
+			angle > frame_reuse.angle_epsilon ||
+			fov_difference > frame_reuse.angle_epsilon)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool XrBridge::render_multi_pass(const render_function_t& render_function)
+{
+	const FrameState& frame_state = this->frame_state;
+
+	// In the case of stereo view, view_index = 0 is the LEFT eye and view_index = 1 is the RIGHT eye.
+	const uint32_t view_count = frame_state.is_single_eye ? 1 : frame_state.view_count;
+	for (uint32_t view_index = 0; view_index < view_count; ++view_index)
+	{
+		uint32_t image_index = 0;
+		if (this->begin_view(view_index, image_index) == false)
+		{
+			return false;
+		}
+
+		// As specified by the OpenXR specification, the left eye has an index of 0 and the right eye an index of 1.
+		// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrViewConfigurationType.html
+		const Eye eye = view_index == 0 ? Eye::LEFT : Eye::RIGHT;
+
+		// Get the FBO. We pass it by reference to avoid touching the reference count.
+		const std::shared_ptr<Fbo>& fbo = this->swapchains[view_index].framebuffers[image_index];
+
+		// Call the user-defined render function
+		const std::chrono::steady_clock::time_point render_function_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+		if (this->is_foveation_enabled)
+		{
+			this->render_foveated_view(render_function, view_index, fbo);
+		}
+		else
+		{
+			render_function(
+				eye,
+				fbo,
+				frame_state.matrices.projection_matrices[view_index],
+				frame_state.matrices.view_matrices[view_index],
+				frame_state.projection_views[view_index].subImage.imageRect.extent.width,
+				frame_state.projection_views[view_index].subImage.imageRect.extent.height);
+		}
+
+		if (this->is_frame_stats_enabled)
+		{
+			this->add_frame_timing(Timing::RENDER_FUNCTION, render_function_start);
+		}
+
+		this->end_view(view_index, image_index);
+	}
+
+	return true;
+}
+
+bool XrBridge::begin_view(const uint32_t view_index, uint32_t& image_index)
+{
+	const Swapchain& current_swapchain = this->swapchains[view_index];
+
+	image_index = this->frame_state.image_indices[view_index];
+	if (this->wait_swapchain_images(current_swapchain, view_index) == false)
+	{
+		return false;
+	}
+
+	const std::shared_ptr<Fbo>& fbo = current_swapchain.framebuffers[image_index];
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->begin_gpu_timer(view_index);
+	}
+
+	if (this->is_visibility_mask_enabled || this->is_density_mask_enabled)
+	{
+		this->prime_depth(fbo, view_index, 1);
+	}
+
+	if (this->is_visibility_mask_enabled)
+	{
+		this->enable_visibility_mask_scissor(view_index, 1);
+	}
+
+	if (this->is_late_latching_enabled)
+	{
+		this->bind_late_latched_matrices();
+	}
+
+	return true;
+}
+
+void XrBridge::end_view(const uint32_t view_index, const uint32_t image_index)
+{
+	const Swapchain& current_swapchain = this->swapchains[view_index];
+
+	if (this->is_visibility_mask_enabled)
+	{
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	if (this->is_density_mask_enabled)
+	{
+		this->reconstruct_density_mask(current_swapchain, image_index, current_swapchain.framebuffers[image_index], view_index, 1);
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->end_gpu_timer();
+	}
+}
+
+bool XrBridge::render_single_pass(const stereo_render_function_t& stereo_render_function)
+{
+	const FrameState& frame_state = this->frame_state;
+
+	// Both eyes are stored in the same swapchain.
+	const Swapchain& current_swapchain = this->swapchains[0];
+
+	const uint32_t image_index = frame_state.image_indices[0];
+	if (this->wait_swapchain_images(current_swapchain, 0) == false)
+	{
+		return false;
+	}
+
+	// Upload the matrices of both eyes. When late latching, they are copied by the GPU.
+	if (this->is_late_latching_enabled)
+	{
+		this->bind_late_latched_matrices();
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, this->stereo_matrices_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(StereoMatrices), &frame_state.matrices);
+		glBindBufferBase(GL_UNIFORM_BUFFER, STEREO_MATRICES_BINDING, this->stereo_matrices_buffer);
+	}
+
+	// Get the FBO. We pass it by reference to avoid touching the reference count.
+	const std::shared_ptr<Fbo>& fbo = current_swapchain.framebuffers[image_index];
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->begin_gpu_timer(0);
+	}
+
+	if (this->is_visibility_mask_enabled || this->is_density_mask_enabled)
+	{
+		this->prime_depth(fbo, 0, frame_state.view_count);
+	}
+
+	if (this->is_visibility_mask_enabled)
+	{
+		this->enable_visibility_mask_scissor(0, frame_state.view_count);
+	}
+
+	// Call the user-defined render function
+	const std::chrono::steady_clock::time_point render_function_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+	const XrExtent2Di& extent = frame_state.projection_views[0].subImage.imageRect.extent;
+	stereo_render_function(fbo, frame_state.matrices, this->stereo_matrices_buffer, extent.width, extent.height);
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->add_frame_timing(Timing::RENDER_FUNCTION, render_function_start);
+	}
+
+	if (this->is_visibility_mask_enabled)
+	{
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	if (this->is_density_mask_enabled)
+	{
+		this->reconstruct_density_mask(current_swapchain, image_index, fbo, 0, frame_state.view_count);
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->end_gpu_timer();
+	}
+
+	return true;
+}
+
+bool XrBridge::create_eye_gaze_action()
+{
+	Foveation& foveation = this->foveation;
+
+	XrActionSetCreateInfo action_set_create_info = {};
+	action_set_create_info.type = XrStructureType::XR_TYPE_ACTION_SET_CREATE_INFO;
+	std::strncpy(action_set_create_info.actionSetName, "xrbridge", XR_MAX_ACTION_SET_NAME_SIZE);
+	std::strncpy(action_set_create_info.localizedActionSetName, "XrBridge", XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE);
+	action_set_create_info.priority = 0;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateActionSet(this->instance, &action_set_create_info, &foveation.action_set), "Failed to create action set.");
+
+	XrActionCreateInfo action_create_info = {};
+	action_create_info.type = XrStructureType::XR_TYPE_ACTION_CREATE_INFO;
+	action_create_info.actionType = XrActionType::XR_ACTION_TYPE_POSE_INPUT;
+	std::strncpy(action_create_info.actionName, "eye_gaze", XR_MAX_ACTION_NAME_SIZE);
+	std::strncpy(action_create_info.localizedActionName, "Eye gaze", XR_MAX_LOCALIZED_ACTION_NAME_SIZE);
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateAction(foveation.action_set, &action_create_info, &foveation.gaze_action), "Failed to create eye gaze action.");
+
+	// https://registry.khronos.org/OpenXR/specs/1.1/html/xrspec.html#XR_EXT_eye_gaze_interaction
+	XrPath interaction_profile_path = XR_NULL_PATH;
+	XrPath gaze_pose_path = XR_NULL_PATH;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrStringToPath(this->instance, "/interaction_profiles/ext/eye_gaze_interaction", &interaction_profile_path), "Failed to create path.");
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrStringToPath(this->instance, "/user/eyes_ext/input/gaze_ext/pose", &gaze_pose_path), "Failed to create path.");
+
+	const XrActionSuggestedBinding suggested_binding = { foveation.gaze_action, gaze_pose_path };
+	XrInteractionProfileSuggestedBinding interaction_profile_suggested_binding = {};
+	interaction_profile_suggested_binding.type = XrStructureType::XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING;
+	interaction_profile_suggested_binding.interactionProfile = interaction_profile_path;
+	interaction_profile_suggested_binding.countSuggestedBindings = 1;
+	interaction_profile_suggested_binding.suggestedBindings = &suggested_binding;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrSuggestInteractionProfileBindings(this->instance, &interaction_profile_suggested_binding), "Failed to suggest eye gaze binding.");
+
+	XrSessionActionSetsAttachInfo session_action_sets_attach_info = {};
+	session_action_sets_attach_info.type = XrStructureType::XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO;
+	session_action_sets_attach_info.countActionSets = 1;
+	session_action_sets_attach_info.actionSets = &foveation.action_set;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrAttachSessionActionSets(this->session, &session_action_sets_attach_info), "Failed to attach action set.");
+
+	XrActionSpaceCreateInfo action_space_create_info = {};
+	action_space_create_info.type = XrStructureType::XR_TYPE_ACTION_SPACE_CREATE_INFO;
+	action_space_create_info.action = foveation.gaze_action;
+	action_space_create_info.poseInActionSpace = {
+		{ 0.0f, 0.0f, 0.0f, 1.0f, }, // Orientation
+		{ 0.0f, 0.0f, 0.0f }, // Position
+	};
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrCreateActionSpace(this->session, &action_space_create_info, &foveation.gaze_space), "Failed to create eye gaze space.");
+
+	return true;
+}
+
+bool XrBridge::update_foveation(const FrameToken& frame)
+{
+	Foveation& foveation = this->foveation;
+	const FrameState& frame_state = this->frame_state;
+
+	// Where the user is looking, in the reference space.
+	bool is_gaze_valid = false;
+	glm::vec3 gaze_direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+	if (foveation.is_eye_gaze_enabled)
+	{
+		const XrActiveActionSet active_action_set = { foveation.action_set, XR_NULL_PATH };
+		XrActionsSyncInfo actions_sync_info = {};
+		actions_sync_info.type = XrStructureType::XR_TYPE_ACTIONS_SYNC_INFO;
+		actions_sync_info.countActiveActionSets = 1;
+		actions_sync_info.activeActionSets = &active_action_set;
+
+		// The actions are not updated while the application is not focused.
+		const XrResult sync_result = this->dispatch.xrSyncActions(this->session, &actions_sync_info);
+
+		if (sync_result != XrResult::XR_SESSION_NOT_FOCUSED)
+		{
+			RETURN_FALSE_ON_OXR_ERROR(sync_result, "Failed to sync actions.");
+
+			XrSpaceLocation gaze_location = {};
+			gaze_location.type = XrStructureType::XR_TYPE_SPACE_LOCATION;
+			RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrLocateSpace(foveation.gaze_space, this->space, frame.predicted_display_time, &gaze_location), "Failed to locate eye gaze.");
+
+			const XrSpaceLocationFlags required_flags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+			is_gaze_valid = (gaze_location.locationFlags & required_flags) == required_flags;
+
+			const XrQuaternionf& orientation = gaze_location.pose.orientation;
+			gaze_direction = glm::quat(orientation.w, orientation.x, orientation.y, orientation.z) * gaze_direction;
+		}
+	}
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		const XrView& current_view = frame_state.views[view_index];
+		const XrRect2Di& image_rect = frame_state.projection_views[view_index].subImage.imageRect;
+
+		const float tan_left = std::tan(current_view.fov.angleLeft);
+		const float tan_right = std::tan(current_view.fov.angleRight);
+		const float tan_down = std::tan(current_view.fov.angleDown);
+		const float tan_up = std::tan(current_view.fov.angleUp);
+
+		// The center of the inset, as the tangents of the angles from the forward direction of the view.
+		float center_x = 0.0f;
+		float center_y = 0.0f;
+
+		if (is_gaze_valid)
+		{
+			const XrQuaternionf& orientation = current_view.pose.orientation;
+			const glm::vec3 direction = glm::inverse(glm::quat(orientation.w, orientation.x, orientation.y, orientation.z)) * gaze_direction;
+
+			if (direction.z < 0.0f)
+			{
+				center_x = direction.x / -direction.z;
+				center_y = direction.y / -direction.z;
+			}
+		}
+
+		// Convert the center to pixels, keeping the inset inside of the view.
+		const int32_t inset_width = glm::max(1, static_cast<int32_t>(image_rect.extent.width * foveation.inset_size));
+		const int32_t inset_height = glm::max(1, static_cast<int32_t>(image_rect.extent.height * foveation.inset_size));
+		const float center_u = (center_x - tan_left) / (tan_right - tan_left);
+		const float center_v = (center_y - tan_down) / (tan_up - tan_down);
+		const int32_t inset_x = glm::clamp(static_cast<int32_t>(center_u * image_rect.extent.width) - inset_width / 2, 0, image_rect.extent.width - inset_width);
+		const int32_t inset_y = glm::clamp(static_cast<int32_t>(center_v * image_rect.extent.height) - inset_height / 2, 0, image_rect.extent.height - inset_height);
+
+		foveation.inset_rects[view_index] = { { image_rect.offset.x + inset_x, image_rect.offset.y + inset_y }, { inset_width, inset_height } };
+
+		// The field of view of the inset is derived from its pixels, so that it lines up exactly with the periphery.
+		XrFovf inset_fov = {};
+		inset_fov.angleLeft = std::atan(tan_left + (tan_right - tan_left) * inset_x / image_rect.extent.width);
+		inset_fov.angleRight = std::atan(tan_left + (tan_right - tan_left) * (inset_x + inset_width) / image_rect.extent.width);
+		inset_fov.angleDown = std::atan(tan_down + (tan_up - tan_down) * inset_y / image_rect.extent.height);
+		inset_fov.angleUp = std::atan(tan_down + (tan_up - tan_down) * (inset_y + inset_height) / image_rect.extent.height);
+
+		foveation.inset_projection_matrices[view_index] = create_projection_matrix(inset_fov, this->near_clipping_plane, this->far_clipping_plane);
+	}
+
+	return true;
+}
+
+void XrBridge::render_foveated_view(const render_function_t& render_function, const uint32_t view_index, const std::shared_ptr<Fbo>& fbo)
+{
+	const FrameState& frame_state = this->frame_state;
+	const Foveation& foveation = this->foveation;
+
+	const Eye eye = view_index == 0 ? Eye::LEFT : Eye::RIGHT;
+	const Swapchain& peripheral_buffer = foveation.peripheral_buffers[view_index];
+	const std::shared_ptr<Fbo>& peripheral_fbo = peripheral_buffer.framebuffers[0];
+	const XrRect2Di& image_rect = frame_state.projection_views[view_index].subImage.imageRect;
+	const XrRect2Di& inset_rect = foveation.inset_rects[view_index];
+
+	// Render the whole field of view at a lower resolution.
+	render_function(
+		eye,
+		peripheral_fbo,
+		frame_state.matrices.projection_matrices[view_index],
+		frame_state.matrices.view_matrices[view_index],
+		peripheral_buffer.width,
+		peripheral_buffer.height);
+
+	// Upscale it to the swapchain image. The depth is copied too, since it may be submitted to the runtime.
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, peripheral_fbo->getHandle());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo->getHandle());
+	glBlitFramebuffer(
+		0, 0, peripheral_buffer.width, peripheral_buffer.height,
+		image_rect.offset.x, image_rect.offset.y, image_rect.offset.x + image_rect.extent.width, image_rect.offset.y + image_rect.extent.height,
+		GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBlitFramebuffer(
+		0, 0, peripheral_buffer.width, peripheral_buffer.height,
+		image_rect.offset.x, image_rect.offset.y, image_rect.offset.x + image_rect.extent.width, image_rect.offset.y + image_rect.extent.height,
+		GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	// Render the inset at full resolution on top of it. The scissor test prevents the render
+	//  function from clearing the rest of the image.
+	fbo->setViewport(0, inset_rect.offset.x, inset_rect.offset.y, inset_rect.extent.width, inset_rect.extent.height);
+	glScissor(inset_rect.offset.x, inset_rect.offset.y, inset_rect.extent.width, inset_rect.extent.height);
+	glEnable(GL_SCISSOR_TEST);
+
+	render_function(
+		eye,
+		fbo,
+		foveation.inset_projection_matrices[view_index],
+		frame_state.matrices.view_matrices[view_index],
+		inset_rect.extent.width,
+		inset_rect.extent.height);
+
+	glDisable(GL_SCISSOR_TEST);
+}
+
+bool XrBridge::fetch_visibility_mask(const uint32_t view_index)
+{
+	if (view_index >= MAX_VIEWS)
+	{
+		XRBRIDGE_ERROR_OUT("Invalid view index for the visibility mask: " << view_index);
+		return false;
+	}
+
+	VisibilityMask& visibility_mask = this->visibility_masks[view_index];
+	visibility_mask.hidden_triangles.clear();
 
-			this->session_state = session_state_changed->state;
+	// Hidden area.
+	XrVisibilityMaskKHR hidden_mesh = {};
+	hidden_mesh.type = XrStructureType::XR_TYPE_VISIBILITY_MASK_KHR;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetVisibilityMaskKHR(this->session, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_index, XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &hidden_mesh), "Failed to get the visibility mask.");
 
-			if (session_state_changed->state == XrSessionState::XR_SESSION_STATE_READY)
-			{
-				XRBRIDGE_DEBUG_OUT("OpenXR session is beginning.");
+	std::vector<XrVector2f> hidden_vertices(hidden_mesh.vertexCountOutput);
+	std::vector<uint32_t> hidden_indices(hidden_mesh.indexCountOutput);
+	hidden_mesh.vertexCapacityInput = static_cast<uint32_t>(hidden_vertices.size());
+	hidden_mesh.vertices = hidden_vertices.data();
+	hidden_mesh.indexCapacityInput = static_cast<uint32_t>(hidden_indices.size());
+	hidden_mesh.indices = hidden_indices.data();
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetVisibilityMaskKHR(this->session, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_index, XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &hidden_mesh), "Failed to get the visibility mask.");
 
-				if (this->begin_session() == false)
-				{
-					XRBRIDGE_ERROR_OUT("Failed to begin OpenXR session.");
-					return false;
-				}
-			}
-			else if (session_state_changed->state == XrSessionState::XR_SESSION_STATE_STOPPING)
-			{
-				XRBRIDGE_DEBUG_OUT("OpenXR session is stopping.");
+	// The mask is drawn without an index buffer.
+	for (const uint32_t index : hidden_indices)
+	{
+		if (index < hidden_vertices.size())
+		{
+			visibility_mask.hidden_triangles.push_back(hidden_vertices[index]);
+		}
+	}
 
-				if (this->end_session() == false)
-				{
-					XRBRIDGE_ERROR_OUT("Failed to end OpenXR session.");
-					return false;
-				}
-			}
-			else if (session_state_changed->state == XrSessionState::XR_SESSION_STATE_LOSS_PENDING)
-			{
-				XRBRIDGE_ERROR_OUT("The OpenXR session is about to be lost.");
-				return false;
-			}
-			else if (session_state_changed->state == XrSessionState::XR_SESSION_STATE_EXITING)
-			{
-				XRBRIDGE_ERROR_OUT("The OpenXR session is about to exit.");
-				return false;
-			}
+	// Outline of the visible area.
+	XrVisibilityMaskKHR visible_outline = {};
+	visible_outline.type = XrStructureType::XR_TYPE_VISIBILITY_MASK_KHR;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetVisibilityMaskKHR(this->session, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_index, XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_LINE_LOOP_KHR, &visible_outline), "Failed to get the visibility mask.");
 
-			break;
+	std::vector<XrVector2f> outline_vertices(visible_outline.vertexCountOutput);
+	std::vector<uint32_t> outline_indices(visible_outline.indexCountOutput);
+	visible_outline.vertexCapacityInput = static_cast<uint32_t>(outline_vertices.size());
+	visible_outline.vertices = outline_vertices.data();
+	visible_outline.indexCapacityInput = static_cast<uint32_t>(outline_indices.size());
+	visible_outline.indices = outline_indices.data();
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrGetVisibilityMaskKHR(this->session, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_index, XrVisibilityMaskTypeKHR::XR_VISIBILITY_MASK_TYPE_LINE_LOOP_KHR, &visible_outline), "Failed to get the visibility mask.");
+
+	// Without an outline, the whole view is considered visible.
+	visibility_mask.visible_min = { -(std::numeric_limits<float>::max)(), -(std::numeric_limits<float>::max)() };
+	visibility_mask.visible_max = { (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)() };
+
+	if (outline_vertices.empty() == false)
+	{
+		visibility_mask.visible_min = outline_vertices[0];
+		visibility_mask.visible_max = outline_vertices[0];
+
+		for (const XrVector2f& vertex : outline_vertices)
+		{
+			visibility_mask.visible_min.x = glm::min(visibility_mask.visible_min.x, vertex.x);
+			visibility_mask.visible_min.y = glm::min(visibility_mask.visible_min.y, vertex.y);
+			visibility_mask.visible_max.x = glm::max(visibility_mask.visible_max.x, vertex.x);
+			visibility_mask.visible_max.y = glm::max(visibility_mask.visible_max.y, vertex.y);
 		}
+	}
+
+	visibility_mask.is_culled_ratio_dirty = true;
+
+	return true;
+}
+
+bool XrBridge::upload_visibility_masks()
+{
+	// All of the masks are stored in the same vertex buffer, one after the other. Each vertex
+	//  stores the index of its view, so that the masks of all the views can be drawn at once.
+	std::vector<float> vertices;
+	GLint first_vertex = 0;
+
+	for (uint32_t view_index = 0; view_index < MAX_VIEWS; ++view_index)
+	{
+		VisibilityMask& visibility_mask = this->visibility_masks[view_index];
+		visibility_mask.first_vertex = first_vertex;
+		visibility_mask.vertex_count = static_cast<GLsizei>(visibility_mask.hidden_triangles.size());
+		first_vertex += visibility_mask.vertex_count;
+
+		for (const XrVector2f& vertex : visibility_mask.hidden_triangles)
+		{
+			vertices.push_back(vertex.x);
+			vertices.push_back(vertex.y);
+			vertices.push_back(static_cast<float>(view_index));
 		}
 	}
 
+	glBindBuffer(GL_ARRAY_BUFFER, this->visibility_mask_vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
 	return true;
 }
 
-bool XrBridge::render(const render_function_t render_function)
+void XrBridge::prime_depth(const std::shared_ptr<Fbo>& fbo, const uint32_t first_view, const uint32_t view_count) const
 {
-	XRBRIDGE_CHECK_RENDERING(true);
+	// Bind the FBO and its viewports.
+	fbo->render();
+
+	// Save the state that is about to change.
+	const GLboolean was_depth_test_enabled = glIsEnabled(GL_DEPTH_TEST);
+	GLint depth_function = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &depth_function);
+	GLboolean depth_mask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+
+	// Clear the depth and draw the masked pixels on the near plane. Only the depth is written.
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_ALWAYS);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// The area hidden by the lenses.
+	if (this->is_visibility_mask_enabled)
+	{
+		const VisibilityMask& first_mask = this->visibility_masks[first_view];
+		const VisibilityMask& last_mask = this->visibility_masks[first_view + view_count - 1];
 
-	XRBRIDGE_CHECK_INITIALIZED(false);
+		glUseProgram(this->visibility_mask_shader);
+		glUniformMatrix4fv(0, MAX_VIEWS, GL_FALSE, glm::value_ptr(this->frame_state.matrices.projection_matrices[0]));
+		glBindVertexArray(this->visibility_mask_vao);
+		glDrawArrays(GL_TRIANGLES, first_mask.first_vertex, last_mask.first_vertex + last_mask.vertex_count - first_mask.first_vertex);
+	}
 
-	XRBRIDGE_CHECK_DEINITIALIZED(true);
+	// The blocks skipped by the density mask.
+	if (this->is_density_mask_enabled)
+	{
+		glUseProgram(this->density_mask.mask_shader);
+		this->set_density_mask_uniforms(first_view, view_count);
+		glBindVertexArray(this->density_mask.vao);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 3, this->stereo_mode == StereoMode::INSTANCED ? view_count : 1);
+	}
 
-	this->is_currently_rendering_flag = true;
+	glBindVertexArray(0);
+	glUseProgram(0);
 
-	XrFrameState frame_state = {};
-	frame_state.type = XrStructureType::XR_TYPE_FRAME_STATE;
-	XrFrameWaitInfo frame_wait_info = {};
-	frame_wait_info.type = XrStructureType::XR_TYPE_FRAME_WAIT_INFO;
-	// Wait for synchronization with the headset display.
-	RETURN_FALSE_ON_OXR_ERROR(xrWaitFrame(this->session, &frame_wait_info, &frame_state), "Faield to wait for frame.");
+	// Restore the state.
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(depth_mask);
+	glDepthFunc(depth_function);
+	if (was_depth_test_enabled == GL_FALSE)
+	{
+		glDisable(GL_DEPTH_TEST);
+	}
+}
 
-	XrFrameBeginInfo frame_begin_info = {};
-	frame_begin_info.type = XrStructureType::XR_TYPE_FRAME_BEGIN_INFO;
-	RETURN_FALSE_ON_OXR_ERROR(xrBeginFrame(this->session, &frame_begin_info), "Failed to begin frame.");
+void XrBridge::set_density_mask_uniforms(const uint32_t first_view, const uint32_t view_count) const
+{
+	std::array<glm::vec4, MAX_VIEWS> fov_tangents = {};
+	std::array<glm::vec4, MAX_VIEWS> view_rects = {};
 
-	std::vector<XrCompositionLayerBaseHeader*> layers = {};
+	for (uint32_t view_offset = 0; view_offset < view_count; ++view_offset)
+	{
+		const XrFovf& fov = this->frame_state.views[first_view + view_offset].fov;
+		const XrRect2Di& image_rect = this->frame_state.projection_views[first_view + view_offset].subImage.imageRect;
 
-	const bool is_session_active =
-		this->session_state == XrSessionState::XR_SESSION_STATE_SYNCHRONIZED ||
-		this->session_state == XrSessionState::XR_SESSION_STATE_VISIBLE ||
-		this->session_state == XrSessionState::XR_SESSION_STATE_FOCUSED;
+		fov_tangents[view_offset] = glm::vec4(std::tan(fov.angleLeft), std::tan(fov.angleRight), std::tan(fov.angleDown), std::tan(fov.angleUp));
+		view_rects[view_offset] = glm::vec4(image_rect.offset.x, image_rect.offset.y, image_rect.extent.width, image_rect.extent.height);
+	}
 
-	bool did_render = false;
+	glUniform4fv(0, MAX_VIEWS, glm::value_ptr(fov_tangents[0]));
+	glUniform4fv(2, MAX_VIEWS, glm::value_ptr(view_rects[0]));
+	glUniform2f(4, this->density_mask.inner_radius, this->density_mask.outer_radius);
+}
 
-	// 3D view
-	XrCompositionLayerProjection composition_layer_projection = {};
-	composition_layer_projection.type = XrStructureType::XR_TYPE_COMPOSITION_LAYER_PROJECTION;
-	composition_layer_projection.layerFlags = NULL_FLAG;
-	composition_layer_projection.space = this->space;
-	composition_layer_projection.viewCount = 0; // This will be filled up later.
-	composition_layer_projection.views = nullptr; // This will be filled up later.
+void XrBridge::reconstruct_density_mask(const Swapchain& swapchain, const uint32_t image_index, const std::shared_ptr<Fbo>& fbo, const uint32_t first_view, const uint32_t view_count) const
+{
+	const GLenum target = swapchain.array_size > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	const GLuint scratch_texture = this->density_mask.scratch_textures[&swapchain - this->swapchains.data()];
+
+	// Copy the area covered by the views, so that the shader can read the neighbours of the skipped pixels.
+	const XrRect2Di& first_rect = this->frame_state.projection_views[first_view].subImage.imageRect;
+	const XrRect2Di& last_rect = this->frame_state.projection_views[first_view + view_count - 1].subImage.imageRect;
+	glCopyImageSubData(
+		swapchain.color_images[image_index], target, 0, first_rect.offset.x, first_rect.offset.y, 0,
+		scratch_texture, target, 0, first_rect.offset.x, first_rect.offset.y, 0,
+		last_rect.offset.x + last_rect.extent.width - first_rect.offset.x, last_rect.offset.y + last_rect.extent.height - first_rect.offset.y, swapchain.array_size);
+
+	// Save the state that is about to change.
+	const GLboolean was_depth_test_enabled = glIsEnabled(GL_DEPTH_TEST);
+	const GLboolean was_framebuffer_srgb_enabled = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+	const GLboolean was_blend_enabled = glIsEnabled(GL_BLEND);
+
+	// Fill in the skipped pixels.
+	fbo->render();
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_FRAMEBUFFER_SRGB);
+	glDisable(GL_BLEND);
+
+	glUseProgram(this->density_mask.reconstruction_shader);
+	this->set_density_mask_uniforms(first_view, view_count);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(target, scratch_texture);
+	glBindVertexArray(this->density_mask.vao);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 3, this->stereo_mode == StereoMode::INSTANCED ? view_count : 1);
+	glBindVertexArray(0);
+	glBindTexture(target, 0);
+	glUseProgram(0);
+
+	// Restore the state.
+	if (was_depth_test_enabled)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
 
-	std::vector<XrCompositionLayerProjectionView> composition_layer_projection_views = {};
+	if (was_framebuffer_srgb_enabled)
+	{
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	}
 
-	if (is_session_active && frame_state.shouldRender)
+	if (was_blend_enabled)
 	{
-		did_render = true;
+		glEnable(GL_BLEND);
+	}
+}
 
-		// 3D view
-		XrViewState view_state = {};
-		view_state.type = XrStructureType::XR_TYPE_VIEW_STATE;
-		XrViewLocateInfo view_locate_info = {};
-		view_locate_info.type = XrStructureType::XR_TYPE_VIEW_LOCATE_INFO;
-		view_locate_info.viewConfigurationType = XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-		view_locate_info.displayTime = frame_state.predictedDisplayTime;
-		view_locate_info.space = this->space;
+void XrBridge::enable_visibility_mask_scissor(const uint32_t first_view, const uint32_t view_count) const
+{
+	const FrameState& frame_state = this->frame_state;
+
+	// When multiple views share the same image, the first scissor rectangle covers all of them,
+	//  since glClear() only uses the first one. With multiview, it is also used by every view.
+	XrRect2Di scissor_rect = frame_state.scissor_rects[first_view];
+
+	for (uint32_t view_index = first_view + 1; view_index < first_view + view_count; ++view_index)
+	{
+		const XrRect2Di& view_scissor_rect = frame_state.scissor_rects[view_index];
+		const int32_t min_x = glm::min(scissor_rect.offset.x, view_scissor_rect.offset.x);
+		const int32_t min_y = glm::min(scissor_rect.offset.y, view_scissor_rect.offset.y);
+		const int32_t max_x = glm::max(scissor_rect.offset.x + scissor_rect.extent.width, view_scissor_rect.offset.x + view_scissor_rect.extent.width);
+		const int32_t max_y = glm::max(scissor_rect.offset.y + scissor_rect.extent.height, view_scissor_rect.offset.y + view_scissor_rect.extent.height);
+		scissor_rect = { { min_x, min_y }, { max_x - min_x, max_y - min_y } };
+	}
 
-		uint32_t view_count = 0;
-		xrLocateViews(this->session, &view_locate_info, &view_state, 0, &view_count, nullptr);
-		std::vector<XrView> views(view_count, { XrStructureType::XR_TYPE_VIEW });
-		xrLocateViews(this->session, &view_locate_info, &view_state, view_count, &view_count, views.data());
+	glScissor(scissor_rect.offset.x, scissor_rect.offset.y, scissor_rect.extent.width, scissor_rect.extent.height);
 
-		// In the case of stereo view, view_index = 0 is the LEFT eye and view_index = 1 is the RIGHT eye.
-		for (uint32_t view_index = 0; view_index < views.size(); ++view_index)
+	// With instancing, each view is drawn in its own viewport, so the other views get their own
+	//  rectangle. The draws of the first view are still confined to its viewport.
+	if (this->stereo_mode == StereoMode::INSTANCED)
+	{
+		for (uint32_t view_index = first_view + 1; view_index < first_view + view_count; ++view_index)
 		{
-			const Swapchain& current_swapchain = this->swapchains.at(view_index);
-			const XrView& current_view = views.at(view_index);
+			const XrRect2Di& view_scissor_rect = frame_state.scissor_rects[view_index];
+			glScissorIndexed(view_index - first_view, view_scissor_rect.offset.x, view_scissor_rect.offset.y, view_scissor_rect.extent.width, view_scissor_rect.extent.height);
+		}
+	}
+
+	glEnable(GL_SCISSOR_TEST);
+}
+
+void XrBridge::record_timing(const Timing timing, const float milliseconds)
+{
+	TimingWindow& window = this->frame_stats.windows[static_cast<size_t>(timing)];
+
+	window.samples[window.next_sample] = milliseconds;
+	window.next_sample = (window.next_sample + 1) % FRAME_STATS_WINDOW_SIZE;
+	window.sample_count = glm::min(window.sample_count + 1, FRAME_STATS_WINDOW_SIZE);
+}
+
+void XrBridge::add_frame_timing(const Timing timing, const std::chrono::steady_clock::time_point start)
+{
+	this->frame_stats.frame_timings[static_cast<size_t>(timing)] += get_elapsed_milliseconds(start);
+}
+
+void XrBridge::begin_gpu_timer(const uint32_t view_index)
+{
+	FrameStatsState& frame_stats = this->frame_stats;
+
+	// If the result of an old query is still not available, it is simply lost.
+	glBeginQuery(GL_TIME_ELAPSED, frame_stats.gpu_queries[frame_stats.gpu_query_frame][view_index]);
+	frame_stats.is_gpu_query_pending[frame_stats.gpu_query_frame][view_index] = true;
+}
+
+void XrBridge::end_gpu_timer()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+void XrBridge::collect_gpu_timers()
+{
+	FrameStatsState& frame_stats = this->frame_stats;
+
+	// Read back the frames that are ready without waiting for the others, from the oldest one.
+	for (uint32_t frame_offset = 1; frame_offset <= GPU_TIMER_LATENCY; ++frame_offset)
+	{
+		const uint32_t query_frame = (frame_stats.gpu_query_frame + frame_offset) % GPU_TIMER_LATENCY;
 
-			uint32_t image_index = 0;
-			XrSwapchainImageAcquireInfo swapchain_image_acquire_info = {};
-			swapchain_image_acquire_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO;
-			RETURN_FALSE_ON_OXR_ERROR(xrAcquireSwapchainImage(current_swapchain.swapchain, &swapchain_image_acquire_info, &image_index), "Failed to acquire swapchain image.");
+		bool is_frame_pending = false;
+		bool is_frame_available = true;
 
-			XrSwapchainImageWaitInfo swapchain_image_wait_info = {};
-			swapchain_image_wait_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO;
-			swapchain_image_wait_info.timeout = XR_INFINITE_DURATION;
-			RETURN_FALSE_ON_OXR_ERROR(xrWaitSwapchainImage(current_swapchain.swapchain, &swapchain_image_wait_info), "Failed to wait for swapchain image.");
+		for (uint32_t view_index = 0; view_index < MAX_VIEWS; ++view_index)
+		{
+			if (frame_stats.is_gpu_query_pending[query_frame][view_index])
+			{
+				GLint is_available = GL_FALSE;
+				glGetQueryObjectiv(frame_stats.gpu_queries[query_frame][view_index], GL_QUERY_RESULT_AVAILABLE, &is_available);
 
-			XrCompositionLayerProjectionView composition_layer_projection_view = {};
-			composition_layer_projection_view.type = XrStructureType::XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
-			composition_layer_projection_view.pose = current_view.pose;
-			composition_layer_projection_view.fov = current_view.fov;
-			composition_layer_projection_view.subImage.swapchain = current_swapchain.swapchain;
-			composition_layer_projection_view.subImage.imageRect.offset.x = 0;
-			composition_layer_projection_view.subImage.imageRect.offset.y = 0;
-			composition_layer_projection_view.subImage.imageRect.extent.width = current_swapchain.width;
-			composition_layer_projection_view.subImage.imageRect.extent.height = current_swapchain.height;
-			composition_layer_projection_view.subImage.imageArrayIndex = 0;
-			composition_layer_projection_views.push_back(composition_layer_projection_view);
+				is_frame_pending = true;
+				is_frame_available = is_frame_available && is_available == GL_TRUE;
+			}
+		}
 
-			// As specified by the OpenXR specification, the left eye has an index of 0 and the right eye an index of 1.
-			// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrViewConfigurationType.html
-			const Eye eye = view_index == 0 ? Eye::LEFT : Eye::RIGHT;
+		if (is_frame_pending == false || is_frame_available == false)
+		{
+			continue;
+		}
 
-			// Create the projection matrix
-			const glm::mat4 projection_matrix = create_projection_matrix(
-				current_view.fov,
-				this->near_clipping_plane,
-				this->far_clipping_plane);
+		float frame_gpu_time = 0.0f;
 
-			// Create the view matrix
-			const glm::quat quaternion = glm::quat(current_view.pose.orientation.w, current_view.pose.orientation.x, current_view.pose.orientation.y, current_view.pose.orientation.z);
-			const glm::mat4 rotation_matrix = glm::mat4_cast(quaternion);
-			const glm::mat4 translation_matrix = glm::translate(glm::mat4(1.0f), XRV_TO_GV(current_view.pose.position));
-			const glm::mat4 view_matrix = translation_matrix * rotation_matrix;
+		for (uint32_t view_index = 0; view_index < MAX_VIEWS; ++view_index)
+		{
+			if (frame_stats.is_gpu_query_pending[query_frame][view_index] == false)
+			{
+				continue;
+			}
 
-			// Get the FBO
-			const std::shared_ptr<Fbo> fbo = current_swapchain.framebuffers.at(image_index);
+			GLuint64 elapsed_time = 0;
+			glGetQueryObjectui64v(frame_stats.gpu_queries[query_frame][view_index], GL_QUERY_RESULT, &elapsed_time);
+			frame_stats.is_gpu_query_pending[query_frame][view_index] = false;
 
-			// Call the user-defined render function
-			render_function(eye, fbo, projection_matrix, view_matrix, current_swapchain.width, current_swapchain.height);
+			const float gpu_time = static_cast<float>(elapsed_time) / 1'000'000.0f;
+			this->record_timing(view_index == 0 ? Timing::GPU_LEFT : Timing::GPU_RIGHT, gpu_time);
+			frame_gpu_time += gpu_time;
+		}
 
-			XrSwapchainImageReleaseInfo swapchain_image_release_info = {};
-			swapchain_image_release_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO;
-			RETURN_FALSE_ON_OXR_ERROR(xrReleaseSwapchainImage(current_swapchain.swapchain, &swapchain_image_release_info), "Failed to release swapchain image.");
+		if (this->is_resolution_scaling_enabled)
+		{
+			this->update_resolution_scale(frame_gpu_time);
 		}
 
-		composition_layer_projection.viewCount = static_cast<uint32_t>(composition_layer_projection_views.size());
-		composition_layer_projection.views = composition_layer_projection_views.data();
+		// Follow increases immediately, and decreases slowly.
+		if (this->is_just_in_time_enabled)
+		{
+			JustInTime& just_in_time = this->just_in_time;
+			just_in_time.gpu_cost = glm::max(frame_gpu_time, glm::mix(just_in_time.gpu_cost, frame_gpu_time, 0.05f));
+		}
 	}
+}
+
+void XrBridge::update_resolution_scale(const float gpu_time)
+{
+	ResolutionScaling& resolution_scaling = this->resolution_scaling;
 
-	if (did_render)
+	// The timings issued before the last change do not reflect the current resolution.
+	if (resolution_scaling.ignored_timing_count > 0)
 	{
-		layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&composition_layer_projection));
+		--resolution_scaling.ignored_timing_count;
+		return;
 	}
 
-	XrFrameEndInfo frame_end_info = {};
-	frame_end_info.type = XrStructureType::XR_TYPE_FRAME_END_INFO;
-	frame_end_info.displayTime = frame_state.predictedDisplayTime;
-	// NOTE: This is the blend mode. In the case of AR, choose something like ALPHA or ADDITTIVE to mix the virtual and real world.
-	frame_end_info.environmentBlendMode = XrEnvironmentBlendMode::XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
-	frame_end_info.layerCount = static_cast<uint32_t>(layers.size());
-	frame_end_info.layers = layers.data();
-	RETURN_FALSE_ON_OXR_ERROR(xrEndFrame(this->session, &frame_end_info), "Failed to end frame.");
+	const float budget = resolution_scaling.display_period * XRBRIDGE_CONFIG_GPU_BUDGET;
 
-	this->is_currently_rendering_flag = false;
+	if (budget <= 0.0f || gpu_time <= 0.0f)
+	{
+		return;
+	}
 
-	return true;
+	// The GPU time is roughly proportional to the number of pixels, which grows with the square of the scale.
+	float scale = resolution_scaling.scale;
+
+	if (gpu_time > budget)
+	{
+		scale *= std::sqrt(budget / gpu_time);
+	}
+	else if (gpu_time < budget * (1.0f - resolution_scaling.hysteresis) && (this->is_watchdog_enabled == false || this->watchdog.level == DegradationLevel::NONE))
+	{
+		// Grow slowly towards the middle of the hysteresis band, to avoid overshooting.
+		const float target = budget * (1.0f - resolution_scaling.hysteresis * 0.5f);
+		scale *= glm::min(std::sqrt(target / gpu_time), 1.05f);
+	}
+
+	scale = glm::clamp(scale, resolution_scaling.min_scale, resolution_scaling.max_scale);
+
+	// Ignore tiny changes.
+	if (std::abs(scale - resolution_scaling.scale) < 0.01f)
+	{
+		return;
+	}
+
+	resolution_scaling.scale = scale;
+	resolution_scaling.is_dirty = true;
+	resolution_scaling.ignored_timing_count = GPU_TIMER_LATENCY;
 }
 
-void XrBridge::set_clipping_planes(const float near_clipping_plane, const float far_clipping_plane)
+void XrBridge::apply_resolution_scale()
 {
-	this->near_clipping_plane = near_clipping_plane;
-	this->far_clipping_plane = far_clipping_plane;
+	ResolutionScaling& resolution_scaling = this->resolution_scaling;
+	FrameState& frame_state = this->frame_state;
+
+	const bool is_multi_pass = this->stereo_mode == StereoMode::MULTI_PASS;
+
+	for (uint32_t view_index = 0; view_index < frame_state.view_count; ++view_index)
+	{
+		const Swapchain& swapchain = this->swapchains[is_multi_pass ? view_index : 0];
+		const XrRect2Di& view_rect = swapchain.view_rects[is_multi_pass ? 0 : view_index];
+		const XrExtent2Di& recommended_extent = resolution_scaling.recommended_extents[view_index];
+
+		// The rendered area starts at the same corner as the full region of the view.
+		XrRect2Di& image_rect = frame_state.projection_views[view_index].subImage.imageRect;
+		image_rect.offset = view_rect.offset;
+		image_rect.extent.width = glm::clamp(static_cast<int32_t>(recommended_extent.width * resolution_scaling.scale), 1, view_rect.extent.width);
+		image_rect.extent.height = glm::clamp(static_cast<int32_t>(recommended_extent.height * resolution_scaling.scale), 1, view_rect.extent.height);
+
+		frame_state.depth_infos[view_index].subImage.imageRect = image_rect;
+	}
+
+	// Update the viewports of the FBOs. With MULTIVIEW, the same viewport is used by all of the layers.
+	for (const Swapchain& swapchain : this->swapchains)
+	{
+		const uint32_t first_view = is_multi_pass ? static_cast<uint32_t>(&swapchain - this->swapchains.data()) : 0;
+		const uint32_t viewport_count = swapchain.array_size > 1 ? 1 : swapchain.view_count;
+
+		for (const std::shared_ptr<Fbo>& fbo : swapchain.framebuffers)
+		{
+			for (uint32_t viewport_index = 0; viewport_index < viewport_count; ++viewport_index)
+			{
+				const XrRect2Di& image_rect = frame_state.projection_views[first_view + viewport_index].subImage.imageRect;
+				fbo->setViewport(viewport_index, image_rect.offset.x, image_rect.offset.y, image_rect.extent.width, image_rect.extent.height);
+			}
+		}
+	}
+
+	resolution_scaling.is_dirty = false;
+
+	XRBRIDGE_DEBUG_OUT("Resolution scale: " << resolution_scaling.scale << " (" << frame_state.projection_views[0].subImage.imageRect.extent.width << "x" << frame_state.projection_views[0].subImage.imageRect.extent.height << " per eye).");
 }
 
-bool XrBridge::begin_session()
+bool XrBridge::acquire_swapchain_images(const Swapchain& swapchain, uint32_t& image_index)
 {
-	XrSessionBeginInfo session_begin_info = {};
-	session_begin_info.type = XrStructureType::XR_TYPE_SESSION_BEGIN_INFO;
-	// NOTE: This is the view cofiguration type that we desire. This use case only requires stereo (two eyes).
-	session_begin_info.primaryViewConfigurationType = XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-	RETURN_FALSE_ON_OXR_ERROR(xrBeginSession(this->session, &session_begin_info), "Faield to begin session.");
+	XrSwapchainImageAcquireInfo swapchain_image_acquire_info = {};
+	swapchain_image_acquire_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO;
+	const std::chrono::steady_clock::time_point acquire_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrAcquireSwapchainImage(swapchain.swapchain, &swapchain_image_acquire_info, &image_index), "Failed to acquire swapchain image.");
 
-	// A view more or less equates to a display. In the case of a VR headset, since we have 2 eyes, we will ave 2 views.
-	uint32_t view_count = 0;
-	RETURN_FALSE_ON_OXR_ERROR(xrEnumerateViewConfigurationViews(this->instance, this->system_id, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 0, &view_count, nullptr), "Faield to enumerate view configuration views.");
-	std::vector<XrViewConfigurationView> view_configuration_views(view_count, { XR_TYPE_VIEW_CONFIGURATION_VIEW });
-	RETURN_FALSE_ON_OXR_ERROR(xrEnumerateViewConfigurationViews(this->instance, this->system_id, XrViewConfigurationType::XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, view_count, &view_count, view_configuration_views.data()), "Faield to enumerate view configuration views.");
+	if (swapchain.depth_swapchain != XR_NULL_HANDLE)
+	{
+		// The depth swapchain is independent from the color swapchain, so the acquired
+		//  depth image may not be the one currently attached to the FBO.
+		uint32_t depth_image_index = 0;
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrAcquireSwapchainImage(swapchain.depth_swapchain, &swapchain_image_acquire_info, &depth_image_index), "Failed to acquire depth swapchain image.");
+
+		// NOTE: We attach the texture directly instead of going through Fbo::bindTexture(), which would allocate memory.
+		const GLuint depth_image = swapchain.depth_images[depth_image_index];
+		glBindFramebuffer(GL_FRAMEBUFFER, swapchain.framebuffers[image_index]->getHandle());
+
+		if (swapchain.array_size > 1)
+		{
+			glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth_image, 0, 0, swapchain.array_size);
+		}
+		else
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_image, 0);
+		}
+	}
+
+	if (this->is_frame_stats_enabled)
+	{
+		this->add_frame_timing(Timing::ACQUIRE_IMAGE, acquire_start);
+	}
+
+	return true;
+}
 
-	if (view_count != 2)
+bool XrBridge::wait_swapchain_images(const Swapchain& swapchain, const uint32_t view_index)
+{
+	const std::chrono::steady_clock::time_point wait_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+	if (this->wait_swapchain_image(swapchain.swapchain) == false)
 	{
-		XRBRIDGE_ERROR_OUT("OpenXR is reporting " << view_count << " views, but only 2 are supported.");
+		XRBRIDGE_ERROR_OUT("Failed to wait for swapchain image.");
 		return false;
 	}
 
-	for (const auto& view_configuration_view : view_configuration_views)
+	if (this->is_frame_stats_enabled)
 	{
-		Swapchain swapchain = {};
-		swapchain.width = view_configuration_view.recommendedImageRectWidth;
-		swapchain.height = view_configuration_view.recommendedImageRectHeight;
+		this->add_frame_timing(Timing::WAIT_IMAGE, wait_start);
+	}
 
-		XrSwapchainCreateInfo swapchain_create_info = {};
-		swapchain_create_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_CREATE_INFO;
-		swapchain_create_info.createFlags = NULL_FLAG;
-		// OpenGL does not support usage flags.
-		swapchain_create_info.usageFlags = NULL_FLAG;
-		swapchain_create_info.format = XRBRIDGE_SWAPCHAIN_FORMAT;
-		swapchain_create_info.width = view_configuration_view.recommendedImageRectWidth;
-		swapchain_create_info.height = view_configuration_view.recommendedImageRectHeight;
-		swapchain_create_info.sampleCount = view_configuration_view.recommendedSwapchainSampleCount;
-		swapchain_create_info.faceCount = 1;
-		swapchain_create_info.arraySize = 1;
-		swapchain_create_info.mipCount = 1;
-		RETURN_FALSE_ON_OXR_ERROR(xrCreateSwapchain(this->session, &swapchain_create_info, &swapchain.swapchain), "Failed to create swapchain.");
+	if (swapchain.depth_swapchain != XR_NULL_HANDLE && this->wait_swapchain_image(swapchain.depth_swapchain) == false)
+	{
+		XRBRIDGE_ERROR_OUT("Failed to wait for depth swapchain image.");
+		return false;
+	}
 
-		// Create the single images inside the swapchain.
-		// If the runtime is using double-buffering, there will be 2 images per swapchain. For triple buffering,
-		//  the images will be 3.
-		uint32_t swapchain_image_count = 0;
-		RETURN_FALSE_ON_OXR_ERROR(xrEnumerateSwapchainImages(swapchain.swapchain, 0, &swapchain_image_count, nullptr), "Failed to enumerate swapchain images.");
-		std::vector<XrSwapchainImageOpenGLKHR> swapchain_images(swapchain_image_count, { XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR }); // NOTE: Change this to use another graphics API.
-		RETURN_FALSE_ON_OXR_ERROR(xrEnumerateSwapchainImages(swapchain.swapchain, swapchain_image_count, &swapchain_image_count, reinterpret_cast<XrSwapchainImageBaseHeader*>(swapchain_images.data())), "Failed to enumerate swapchain images.");
+	if (this->is_frame_stats_enabled)
+	{
+		this->add_frame_timing(view_index == 0 ? Timing::WAIT_IMAGE_LEFT : Timing::WAIT_IMAGE_RIGHT, wait_start);
+	}
 
-		for (const auto& swapchain_image : swapchain_images)
-		{
-			const std::shared_ptr<Fbo> fbo = this->create_fbo(swapchain_image.image, swapchain.width, swapchain.height);
+	return true;
+}
 
-			if (fbo == nullptr)
-			{
-				XRBRIDGE_ERROR_OUT("Failed to create FBO.");
-				return false;
-			}
+bool XrBridge::wait_swapchain_image(const XrSwapchain swapchain)
+{
+	XrSwapchainImageWaitInfo swapchain_image_wait_info = {};
+	swapchain_image_wait_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO;
+	swapchain_image_wait_info.timeout = XRBRIDGE_CONFIG_SWAPCHAIN_WAIT_TIMEOUT;
 
-			swapchain.framebuffers.push_back(fbo);
+	// The wait is bounded, so that the time the compositor holds on to the image can be counted.
+	XrResult result = this->dispatch.xrWaitSwapchainImage(swapchain, &swapchain_image_wait_info);
+	for (uint32_t timeout_count = 1; result == XrResult::XR_TIMEOUT_EXPIRED; ++timeout_count)
+	{
+		++this->frame_stats.wait_image_timeout_count;
+
+		if (timeout_count >= XRBRIDGE_CONFIG_SWAPCHAIN_WAIT_MAX_TIMEOUTS)
+		{
+			XRBRIDGE_ERROR_OUT("The compositor has not released the swapchain image in time.");
+			return false;
 		}
 
-		this->swapchains.push_back(swapchain);
+		result = this->dispatch.xrWaitSwapchainImage(swapchain, &swapchain_image_wait_info);
 	}
 
-	// Create the reference space.
-	XrReferenceSpaceCreateInfo reference_space_info = {};
-	reference_space_info.type = XrStructureType::XR_TYPE_REFERENCE_SPACE_CREATE_INFO;
-	// https://registry.khronos.org/OpenXR/specs/1.1/man/html/XrReferenceSpaceType.html
-	reference_space_info.referenceSpaceType = XRBRIDGE_CONFIG_SPACE;
-	// Here we set the offset to the origin of the tracking space. In this case, we keep the origin were it is.
-	reference_space_info.poseInReferenceSpace = {
-		{ 0.0f, 0.0f, 0.0f, 1.0f, }, // Orientation
-		{ 0.0f, 0.0f, 0.0f }, // Position
-	};
+	return check_openxr_result(this->instance, result);
+}
+
+bool XrBridge::release_swapchain_images(const Swapchain& swapchain) const
+{
+	XrSwapchainImageReleaseInfo swapchain_image_release_info = {};
+	swapchain_image_release_info.type = XrStructureType::XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO;
+	RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrReleaseSwapchainImage(swapchain.swapchain, &swapchain_image_release_info), "Failed to release swapchain image.");
 
-	RETURN_FALSE_ON_OXR_ERROR(xrCreateReferenceSpace(this->session, &reference_space_info, &this->space), "Failed to create reference space.");
+	if (swapchain.depth_swapchain != XR_NULL_HANDLE)
+	{
+		RETURN_FALSE_ON_OXR_ERROR(this->dispatch.xrReleaseSwapchainImage(swapchain.depth_swapchain, &swapchain_image_release_info), "Failed to release depth swapchain image.");
+	}
 
 	return true;
 }
 
-bool XrBridge::end_session()
+GLuint XrBridge::create_depth_texture(const Swapchain& swapchain) const
 {
-	// Destroy swapchains.
-	for (const auto& swapchain : this->swapchains)
-	{
-		RETURN_FALSE_ON_OXR_ERROR(xrDestroySwapchain(swapchain.swapchain), "Failed to destroy swapchain.");
-	}
+	const GLenum target = swapchain.array_size > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 
-	this->swapchains.clear();
+	GLuint depth_texture = 0;
+	glGenTextures(1, &depth_texture);
+	glBindTexture(target, depth_texture);
 
-	// Destroy space.
-	if (this->space != XR_NULL_HANDLE)
+	if (target == GL_TEXTURE_2D_ARRAY)
 	{
-		RETURN_FALSE_ON_OXR_ERROR(xrDestroySpace(this->space), "Failed to destroy space.");
-		this->space = XR_NULL_HANDLE;
+		glTexStorage3D(target, 1, get_depth_format_internal_format(this->depth_format), swapchain.width, swapchain.height, swapchain.array_size);
+	}
+	else
+	{
+		glTexStorage2D(target, 1, get_depth_format_internal_format(this->depth_format), swapchain.width, swapchain.height);
 	}
 
-	// End the session.
-	RETURN_FALSE_ON_OXR_ERROR(xrEndSession(this->session), "Failed to end session.");
+	glBindTexture(target, 0);
 
-	return true;
+	return depth_texture;
 }
 
-std::shared_ptr<Fbo> XrBridge::create_fbo(const GLuint color, const GLsizei width, const GLsizei height) const
+std::shared_ptr<Fbo> XrBridge::create_fbo(const GLuint color, const GLuint depth, const Swapchain& swapchain) const
 {
 	std::shared_ptr<Fbo> fbo = std::make_shared<Fbo>();
 
+	const GLsizei array_size = static_cast<GLsizei>(swapchain.array_size);
+	const bool is_layered = array_size > 1;
+
 	// Color attacment
-	if (fbo->bindTexture(0, Fbo::BIND_COLORTEXTURE, color) == false)
+	if (fbo->bindTexture(0, is_layered ? Fbo::BIND_COLORTEXTURE_MULTIVIEW : Fbo::BIND_COLORTEXTURE, color, 0, array_size) == false)
 	{
 		Fbo::disable();
 		return nullptr;
 	}
 
 	// Depth attachment
-	if (fbo->bindRenderBuffer(1, Fbo::BIND_DEPTHBUFFER, width, height) == false)
+	if (fbo->bindTexture(1, is_layered ? Fbo::BIND_DEPTHTEXTURE_MULTIVIEW : Fbo::BIND_DEPTHTEXTURE, depth, 0, array_size) == false)
 	{
 		Fbo::disable();
 		return nullptr;
 	}
 
+	// When multiple views share the same image side by side, each view gets its own viewport.
+	if (is_layered == false && swapchain.view_count > 1)
+	{
+		for (uint32_t view_index = 0; view_index < swapchain.view_count; ++view_index)
+		{
+			const XrRect2Di& view_rect = swapchain.view_rects[view_index];
+
+			if (fbo->setViewport(view_index, view_rect.offset.x, view_rect.offset.y, view_rect.extent.width, view_rect.extent.height) == false)
+			{
+				Fbo::disable();
+				return nullptr;
+			}
+		}
+	}
+
 	if (fbo->isOk() == false)
 	{
 		Fbo::disable();
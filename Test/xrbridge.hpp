@@ -6,9 +6,16 @@
  * For the OpenXR API documentation: https://registry.khronos.org/OpenXR/specs/1.0/man/html/FUNCTION_OR_STRUCT.html
  */
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
@@ -41,7 +48,388 @@ public:
 	/**
 		* The signature of the user-provided render function.
 		*/
-	typedef std::function<void(const Eye eye, const std::shared_ptr<Fbo> fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height)> render_function_t;
+	typedef std::function<void(const Eye eye, const std::shared_ptr<Fbo>& fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height)> render_function_t;
+
+	/**
+		* Everything needed to render a single view, as received by the render function
+		* passed to the template overloads of `render()` and `end_frame()`.
+		*
+		* The references are only valid inside the render function.
+		*/
+	struct View
+	{
+		/**
+			* The eye that is currently being rendered.
+			*/
+		Eye eye;
+
+		/**
+			* The current OpenGL FBO.
+			*/
+		Fbo& fbo;
+
+		/**
+			* The projection matrix to be used for rendering.
+			*/
+		const glm::mat4& projection_matrix;
+
+		/**
+			* The view matrix to be used for rendering.
+			*/
+		const glm::mat4& view_matrix;
+
+		/**
+			* The projection matrix multiplied by the inverse of the view matrix.
+			*/
+		const glm::mat4& view_projection_matrix;
+
+		/**
+			* The inverse of the view matrix.
+			*/
+		const glm::mat4& inverse_view_matrix;
+
+		/**
+			* The size of the area to render.
+			*/
+		uint32_t width;
+		uint32_t height;
+	};
+
+	/**
+		* The available stereo rendering modes.
+		*
+		* * `MULTI_PASS`: Each eye has its own swapchain and the render function is
+		* called once per eye. This is the default.
+		* * `MULTIVIEW`: Both eyes share a single swapchain with 2 array layers. The stereo
+		* render function is called only once and both eyes are rendered in a single
+		* pass through `GL_OVR_multiview2`.
+		* * `INSTANCED`: Both eyes share a single swapchain twice as wide as a single eye,
+		* with the LEFT eye on the left half and the RIGHT eye on the right half. The stereo
+		* render function is called only once. The FBO has one viewport per eye, and the
+		* geometry is drawn once with 2 instances, routing each instance to its eye through
+		* `gl_ViewportIndex` (`GL_ARB_shader_viewport_layer_array`). Use this when
+		* `GL_OVR_multiview2` is not available.
+		*/
+	enum class StereoMode { MULTI_PASS, MULTIVIEW, INSTANCED };
+
+	/**
+		* The steps taken by the overrun watchdog, from the mildest to the most severe.
+		* Refer to `set_overrun_watchdog()`.
+		*
+		* * `NONE`: The frames are rendered normally.
+		* * `REDUCED_RESOLUTION`: The resolution is dropped to the minimum scale of the
+		* resolution scaling, and not increased again until the watchdog recovers.
+		* Requires `set_resolution_scaling()`.
+		* * `SINGLE_EYE`: Only the LEFT eye is rendered, and its image is submitted for the
+		* RIGHT eye too, where the runtime reprojects it. Requires `StereoMode::MULTI_PASS`,
+		* and is not available with the foveation or the late latching.
+		* * `REUSED_FRAME`: The render function is not called, and the last rendered frame
+		* is submitted again, like with `set_frame_reuse()`.
+		*/
+	enum class DegradationLevel { NONE, REDUCED_RESOLUTION, SINGLE_EYE, REUSED_FRAME };
+
+	/**
+		* The available formats of the depth buffers.
+		*
+		* * `D16`: 16 bit normalized depth.
+		* * `D24`: 24 bit normalized depth. This is the default.
+		* * `D32F`: 32 bit floating point depth.
+		*/
+	enum class DepthFormat { D16, D24, D32F };
+
+	/**
+		* The uniform buffer binding point of the `StereoMatrices` buffer. The buffer
+		* is bound to this binding point before calling the stereo render function (and
+		* the render function, when late latching is enabled).
+		*/
+	static const GLuint STEREO_MATRICES_BINDING = 0;
+
+	/**
+		* The matrices of both eyes. Index 0 is the LEFT eye and index 1 is the RIGHT eye.
+		*
+		* The uniform buffer passed to the stereo render function contains this structure
+		* and matches the following GLSL declaration:
+		* ```GLSL
+		* layout(std140, binding = 0) uniform XrBridgeStereoMatrices
+		* {
+		*         mat4 projection_matrices[2];
+		*         mat4 view_matrices[2];
+		*         mat4 view_projection_matrices[2];
+		* };
+		* ```
+		*/
+	struct StereoMatrices
+	{
+		/**
+			* The projection matrices, as received by the render function.
+			*/
+		glm::mat4 projection_matrices[2];
+
+		/**
+			* The view matrices, as received by the render function.
+			*/
+		glm::mat4 view_matrices[2];
+
+		/**
+			* The projection matrices multiplied by the inverse of the view matrices.
+			*/
+		glm::mat4 view_projection_matrices[2];
+	};
+
+	/**
+		* The signature of the user-provided stereo render function.
+		*/
+	typedef std::function<void(const std::shared_ptr<Fbo>& fbo, const StereoMatrices& matrices, const GLuint matrices_buffer, const uint32_t width, const uint32_t height)> stereo_render_function_t;
+
+	/**
+		* A single frustum containing the frusta of both eyes. Use this to cull, or to fit
+		* shadow maps, once per frame instead of once per eye.
+		*
+		* The frustum starts behind the eyes, so that both of them are inside of it, and
+		* extends from the near clipping plane to past the far clipping plane.
+		*/
+	struct StereoFrustum
+	{
+		/**
+			* The projection matrix of the frustum.
+			*/
+		glm::mat4 projection_matrix;
+
+		/**
+			* The view matrix of the frustum, like the view matrices of the eyes.
+			*/
+		glm::mat4 view_matrix;
+
+		/**
+			* The projection matrix multiplied by the inverse of the view matrix.
+			*/
+		glm::mat4 view_projection_matrix;
+	};
+
+	/**
+		* The signature of the user-provided pre-pass function. Refer to `set_pre_pass_function()`.
+		*/
+	typedef std::function<void(const StereoMatrices& matrices, const StereoFrustum& frustum, const XrTime predicted_display_time)> pre_pass_function_t;
+
+	/**
+		* The signature of a slack task. Refer to `add_slack_task()`.
+		*
+		* The function returns `true` when the task is finished, and `false` to be called
+		* again in a later frame.
+		*/
+	typedef std::function<bool(void)> slack_task_t;
+
+	/**
+		* An immutable snapshot of what the application wants to render, pushed to the
+		* render thread with `push_frame_packet()`. Refer to `start_render_thread()`.
+		*/
+	struct FramePacket
+	{
+		/**
+			* The data of the application, for example its draw lists and its camera.
+			* This is `nullptr` until the first packet is received.
+			*/
+		std::shared_ptr<const void> data;
+
+		/**
+			* When the packet was pushed.
+			*/
+		std::chrono::steady_clock::time_point push_time;
+	};
+
+	/**
+		* A token representing a single frame.
+		*
+		* A token is obtained from `wait_frame()` and **must** then be passed to
+		* `begin_frame()` and `end_frame()`, in this order.
+		*/
+	struct FrameToken
+	{
+		/**
+			* The time at which the runtime predicts the frame will be displayed,
+			* in nanoseconds. Use this to advance animations and simulations.
+			*/
+		XrTime predicted_display_time;
+
+		/**
+			* The predicted amount of time between two displayed frames, in nanoseconds.
+			*/
+		XrDuration predicted_display_period;
+
+		/**
+			* Whether the runtime wants the application to render this frame. If this is
+			* `false`, `end_frame()` will submit an empty frame without calling the
+			* render function.
+			*/
+		bool should_render;
+
+		/**
+			* Whether `wait_frame()` has completed successfully for this frame.
+			*/
+		bool is_waited;
+
+		/**
+			* Whether `begin_frame()` has completed successfully for this frame.
+			*/
+		bool is_begun;
+
+		/**
+			* The time spent inside `xrWaitFrame`, in milliseconds. This is only measured
+			* when the frame statistics are enabled.
+			*/
+		float wait_frame_time;
+
+		/**
+			* The time spent inside `xrBeginFrame`, in milliseconds. This is only measured
+			* when the frame statistics are enabled.
+			*/
+		float begin_frame_time;
+
+		/**
+			* When `xrWaitFrame` returned. This is only measured when the just-in-time
+			* start or the slack tasks are enabled.
+			*/
+		std::chrono::steady_clock::time_point wait_frame_end;
+	};
+
+	/**
+		* The rolling percentiles of a timing, in milliseconds.
+		*/
+	struct TimingStats
+	{
+		float p50;
+		float p95;
+		float p99;
+	};
+
+	/**
+		* The timing statistics of the most recent frames. Refer to `set_frame_stats()`.
+		*
+		* All of the CPU timings are measured on the thread calling the method. When an eye
+		* is rendered more than once per frame, the timings of the views are added together.
+		*/
+	struct FrameStats
+	{
+		/**
+			* The number of frames submitted since the statistics were enabled.
+			*/
+		uint64_t frame_count;
+
+		/**
+			* The number of display periods in which no new frame was displayed, derived
+			* from the gaps between the predicted display times of consecutive frames.
+			*/
+		uint64_t missed_frame_count;
+
+		/**
+			* The time spent waiting for the runtime inside `xrWaitFrame`.
+			*/
+		TimingStats wait_frame;
+
+		/**
+			* The time spent inside `xrBeginFrame`.
+			*/
+		TimingStats begin_frame;
+
+		/**
+			* The time spent inside `xrAcquireSwapchainImage`.
+			*/
+		TimingStats acquire_image;
+
+		/**
+			* The time spent inside `xrWaitSwapchainImage`.
+			*/
+		TimingStats wait_image;
+
+		/**
+			* The time spent waiting for the images of each eye (index 0 is the LEFT eye and
+			* index 1 is the RIGHT eye), including the depth images. The images of all of the
+			* eyes are acquired before the first eye is rendered, and each one is waited
+			* right before being rendered, so a long wait here means that the compositor is
+			* still reading the image. When both eyes are rendered at once, the wait is
+			* reported in index 0.
+			*/
+		TimingStats eye_wait_image[2];
+
+		/**
+			* The number of times a wait for a swapchain image did not complete within
+			* `XRBRIDGE_CONFIG_SWAPCHAIN_WAIT_TIMEOUT` and had to be repeated.
+			*/
+		uint64_t wait_image_timeout_count;
+
+		/**
+			* The CPU time spent inside the render function.
+			*/
+		TimingStats render_function;
+
+		/**
+			* The time spent inside `xrEndFrame`.
+			*/
+		TimingStats end_frame;
+
+		/**
+			* The GPU time of each eye (index 0 is the LEFT eye and index 1 is the RIGHT eye),
+			* including the preparation done by XrBridge. When both eyes are rendered at once,
+			* the time of both eyes is reported in index 0.
+			*/
+		TimingStats gpu_time[2];
+
+		/**
+			* The time between the sampling of the head pose (`xrLocateViews`) and the
+			* submission of the frame (`xrEndFrame`).
+			*/
+		TimingStats pose_to_end_frame;
+
+		/**
+			* The time spent waiting for the GPU to finish older frames before starting a
+			* new one. Refer to `set_frames_in_flight()`.
+			*/
+		TimingStats frames_in_flight_wait;
+
+		/**
+			* The time between the push of the frame packet rendered in a frame and the
+			* submission of the frame. Refer to `start_render_thread()`.
+			*/
+		TimingStats frame_packet_age;
+
+		/**
+			* The number of frame packets pushed between the last two frames. Only the newest
+			* one is rendered, and if none was pushed the previous one is rendered again.
+			*/
+		uint32_t frame_packet_queue_depth;
+
+		/**
+			* The number of frame packets that were replaced by a newer one before the render
+			* thread could read them, so they were never rendered.
+			*/
+		uint64_t dropped_frame_packet_count;
+
+		/**
+			* The time spent sleeping before starting a frame. Refer to `set_just_in_time_start()`.
+			*/
+		TimingStats just_in_time_sleep;
+
+		/**
+			* The current safety margin of the just-in-time start, in milliseconds.
+			*/
+		float just_in_time_margin;
+
+		/**
+			* The time spent running slack tasks after each frame. Refer to `set_slack_tasks()`.
+			*/
+		TimingStats slack_tasks;
+
+		/**
+			* The number of slack tasks waiting to be run or to be resumed.
+			*/
+		uint32_t pending_slack_task_count;
+
+		/**
+			* The number of frames in which the render function took longer than allowed by
+			* the overrun watchdog. Refer to `set_overrun_watchdog()`.
+			*/
+		uint64_t overrun_count;
+	};
 
 	/**
 		* Default constructor.
@@ -51,6 +439,14 @@ public:
 		*/
 	XrBridge();
 
+	/**
+		* Destructor.
+		*
+		* Stops the render thread and the event thread if they are still running. Does
+		* **not** free the OpenXR resources. For that, use the `free()` method.
+		*/
+	~XrBridge();
+
 	// Since we are managing resources, we should prevent the user from creating copies of this object!
 	XrBridge(const XrBridge&) = delete;
 	XrBridge& operator=(const XrBridge&) = delete;
@@ -77,6 +473,8 @@ public:
 		* You **must** call this method when you wish to terminate the OpenXR session.
 		* You **must not** call any other method of this object after.
 		*
+		* If the render thread is running, it is stopped first.
+		*
 		* This method **must not** be called inside the render function, before this object
 		* has been initialized or after this object has already been de-initialized.
 		*
@@ -98,6 +496,37 @@ public:
 		*/
 	bool update(void);
 
+	/**
+		* Check whether the OpenXR session is running, which is the case from when the runtime
+		* reports it as ready until it asks to stop it.
+		*
+		* While the session is not running, `render()` and `render_stereo()` return
+		* immediately without rendering anything, and `wait_frame()` **must not** be called.
+		*
+		* @return `true` if the session is running, `false` otherwise.
+		*/
+	bool is_session_running(void) const;
+
+	/**
+		* Handle OpenXR events until the session is running or the timeout expires, sleeping
+		* between them. Use this instead of `update()` while `is_session_running()` is
+		* `false`, so that the application does not keep a core busy while the headset is
+		* not in use.
+		*
+		* OpenXR does not provide a way to block until an event arrives, so the events are
+		* polled with an increasing interval, which is reset whenever the state of the
+		* session changes.
+		*
+		* This method **must not** be called inside the render function, before this object
+		* has been initialized or after this object has been de-initialized.
+		*
+		* @param timeout The longest time to wait for.
+		*
+		* @return `true` if no error occurred, `false` otherwise. Use `is_session_running()`
+		* to know whether the session is running.
+		*/
+	bool wait_for_session_active(const std::chrono::milliseconds timeout);
+
 	/**
 		* Render the scene to the VR headset.
 		*
@@ -112,6 +541,10 @@ public:
 		*
 		* NOTE: The matrices received represent coordinates in meters.
 		*
+		* NOTE: Once the session is running, this method does not allocate any memory.
+		* To keep the whole frame loop allocation-free, create the `render_function_t`
+		* once outside of the loop instead of passing a new lambda each frame.
+		*
 		* This method **must not** be called inside the render function, before this object
 		* has been initialized or after this object has been de-initialized.
 		*
@@ -121,61 +554,1451 @@ public:
 		* `render_function` **must** have the following parameters
 		* in the specified order and return `void`:
 		* 1. `const XrBridge::Eye eye`: The eye that is currently being rendered.
-		* 2. `std::shared_ptr<Fbo> fbo`: A shared pointer to the current OpenGL FBO.
+		* 2. `const std::shared_ptr<Fbo>& fbo`: A shared pointer to the current OpenGL FBO.
 		* You **must not** store this pointer outside of the `render_function`!
 		* 3. `const glm::mat4 projection_matrix`: The projection matrix to be used for rendering.
 		* 4. `const glm::mat4 view_matrix`: The view matrix to be used for rendering.
+		* 5. `const uint32_t width`: The width of the area to render. This may change between
+		* frames when the resolution is scaled. Refer to `set_resolution_scaling()`.
+		* 6. `const uint32_t height`: The height of the area to render.
 		*
 		* @return `true` if no error occurred, `false` otherwise.
 		*
 		* Example using a lambda:
 		* ```CPP
-		* xrbridge.render([&] (const XrBridge::Eye eye, std::shared_ptr<Fbo> fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix) {
+		* xrbridge.render([&] (const XrBridge::Eye eye, const std::shared_ptr<Fbo>& fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height) {
 		*         // Render stuff here.
 		* }
 		* ```
 		*/
-	bool render(const render_function_t render_function);
+	bool render(const render_function_t& render_function);
 
 	/**
-		* Sets the far and near clipping planes used to generate the projection matrix.
+		* Same as `render()`, but the render function receives a single `const XrBridge::View&`
+		* parameter instead.
 		*
-		* @param near_clipping_plane The near clipping plane. Default: 0.1f
-		* @param far_clipping_plane The far clipping plane. Default: 65'536.0f
+		* The render function is not wrapped in a `std::function`, so the compiler can inline
+		* it, and the matrices are not copied. Prefer this in new code.
+		*
+		* Example using a lambda:
+		* ```CPP
+		* xrbridge.render([&] (const XrBridge::View& view) {
+		*         // Render stuff here.
+		* });
+		* ```
+		*
+		* @param render_function A user-provided render function.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
 		*/
-	void set_clipping_planes(const float near_clipping_plane, const float far_clipping_plane);
-private:
-	// This is used to easily tie together swapchains with their framebuffer IDs and sizes.
-	struct Swapchain
-	{
-		/**
-			* The OpenXR swapchain.
-			*/
-		XrSwapchain swapchain;
-
-		/**
-			* All of the FBOs assigned to this swapchain.
-			*
-			* In the case of double-buffering, the framebuffers will be 2. In case of
-			* triple-buffering, the framebuffers will be 3.
-			*/
-		std::vector<std::shared_ptr<Fbo>> framebuffers;
+	template <typename F, typename = decltype(std::declval<F&>()(std::declval<const View&>()))>
+	bool render(F&& render_function);
 
-		/**
-			* The width in pixels of the view.
-			*/
-		uint32_t width;
+	/**
+		* Render the scene to the VR headset, rendering both eyes at once.
+		*
+		* This method can only be used when the stereo mode is not `MULTI_PASS`.
+		* Refer to `set_stereo_mode()`. Other than that, it behaves like `render()`.
+		*
+		* This method **must not** be called inside the render function, before this object
+		* has been initialized or after this object has been de-initialized.
+		*
+		* @param stereo_render_function A user-provided render function. This function will
+		* be called once per frame (or not at all) and will receive the following parameters:
+		* 1. `const std::shared_ptr<Fbo>& fbo`: A shared pointer to the current OpenGL FBO.
+		* You **must not** store this pointer outside of the `stereo_render_function`!
+		* 2. `const XrBridge::StereoMatrices& matrices`: The matrices of both eyes.
+		* 3. `const GLuint matrices_buffer`: A uniform buffer containing `matrices`. It is
+		* already bound to `XrBridge::STEREO_MATRICES_BINDING`. When late latching is
+		* enabled, only a range of it is bound, so do not bind it again.
+		* 4. `const uint32_t width`: The width of a single eye.
+		* 5. `const uint32_t height`: The height of a single eye.
+		*
+		* When using `MULTIVIEW`, the shaders **must** enable the `GL_OVR_multiview2`
+		* extension, declare `layout(num_views = 2) in;` and select the matrices of the
+		* current eye through `gl_ViewID_OVR`.
+		*
+		* When using `INSTANCED`, each draw call **must** be instanced twice as many times,
+		* and the vertex shaders **must** enable the `GL_ARB_shader_viewport_layer_array`
+		* extension and write the eye index (for example `gl_InstanceID % 2`) to
+		* `gl_ViewportIndex`. `Fbo::render()` sets up the viewports of both eyes.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool render_stereo(const stereo_render_function_t& stereo_render_function);
 
+	/**
+		* Wait for the runtime to be ready for the next frame.
+		*
+		* This is the first of the three frame phases (`wait_frame()`, `begin_frame()`
+		* and `end_frame()`). Calling the three methods in sequence is equivalent to
+		* calling `render()`, but gives access to the frame timing before committing
+		* to a frame. This allows the application to, for example, advance its
+		* simulation to `predicted_display_time` while the previous frame is still
+		* being processed by the GPU.
+		*
+		* Unlike the other methods of this object, this method **may** be called
+		* from a different thread than the one calling `begin_frame()` and
+		* `end_frame()`, as allowed by the OpenXR specification. However, the calls
+		* **must** still be ordered: a frame must be begun before waiting for the next
+		* one. This method **must not** be called concurrently with `update()`.
+		*
+		* This method **must not** be called before this object has been initialized
+		* or after this object has been de-initialized.
+		*
+		* @param frame The token that will receive the frame information.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool wait_frame(FrameToken& frame);
+
+	/**
+		* Begin the frame previously waited with `wait_frame()`.
+		*
+		* This method **must not** be called inside the render function, before this object
+		* has been initialized or after this object has been de-initialized.
+		*
+		* @param frame The token obtained from `wait_frame()`.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool begin_frame(FrameToken& frame);
+
+	/**
+		* Render the views of the frame and submit it to the runtime.
+		*
+		* Refer to the `render()` method for the details about `render_function`.
+		*
+		* This method **must not** be called inside the render function, before this object
+		* has been initialized or after this object has been de-initialized.
+		*
+		* @param frame The token obtained from `wait_frame()` and begun with `begin_frame()`.
+		* @param render_function A user-provided render function.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool end_frame(FrameToken& frame, const render_function_t& render_function);
+
+	/**
+		* Same as `end_frame()`, but for the render functions receiving a `View`. Refer to
+		* the template overload of `render()`.
+		*
+		* @param frame The token obtained from `wait_frame()` and begun with `begin_frame()`.
+		* @param render_function A user-provided render function.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	template <typename F, typename = decltype(std::declval<F&>()(std::declval<const View&>()))>
+	bool end_frame(FrameToken& frame, F&& render_function);
+
+	/**
+		* Same as `end_frame()`, but for the stereo render function. Refer to `render_stereo()`.
+		*
+		* @param frame The token obtained from `wait_frame()` and begun with `begin_frame()`.
+		* @param stereo_render_function A user-provided stereo render function.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool end_frame_stereo(FrameToken& frame, const stereo_render_function_t& stereo_render_function);
+
+	/**
+		* Start a thread that runs the whole frame loop, so that the application thread
+		* never blocks on the runtime.
+		*
+		* The OpenGL context, which **must** be current on the calling thread, is moved to
+		* the render thread. Until `stop_render_thread()` is called, the render thread
+		* handles the events and calls `render()` (`render_stereo()` for this method's
+		* `_stereo` variant) over and over, and the application thread **must not** use
+		* OpenGL nor call any method of this object other than `push_frame_packet()`,
+		* `get_frame_stats()`, `stop_render_thread()` and `free()`, which stops the render
+		* thread first. The other methods fail with an error when called from another thread
+		* while the render thread runs, except for the getters, which cannot report it.
+		*
+		* The application describes each frame with a packet pushed with
+		* `push_frame_packet()`. The render function reads the newest packet with
+		* `get_frame_packet()`, so a packet may be rendered more than once and older
+		* packets are skipped.
+		*
+		* On X11, `XInitThreads()` **must** be called before the window is created.
+		*
+		* This method **must** only be called with `StereoMode::MULTI_PASS`, and **must not**
+		* be called inside the render function, before this object has been initialized
+		* or after this object has been de-initialized.
+		*
+		* @param render_function The render function. Refer to `render()`.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool start_render_thread(const render_function_t& render_function);
+
+	/**
+		* Same as `start_render_thread()`, but calls `render_stereo()`.
+		*
+		* This method **must not** be called with `StereoMode::MULTI_PASS`.
+		*
+		* @param stereo_render_function The render function. Refer to `render_stereo()`.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool start_render_thread_stereo(const stereo_render_function_t& stereo_render_function);
+
+	/**
+		* Stop the render thread, and make the OpenGL context current on the calling thread
+		* again.
+		*
+		* This method **must not** be called inside the render function.
+		*
+		* @return `true` if no error occurred on either thread, `false` otherwise.
+		*/
+	bool stop_render_thread(void);
+
+	/**
+		* Push the packet of a frame to the render thread. This never blocks: if the render
+		* thread has not read the previous packet yet, the previous packet is dropped, so the
+		* render thread always reads the newest one.
+		*
+		* This method **must** be called from a single thread, while the render thread is
+		* running.
+		*
+		* @param data The data of the application. It **must not** be modified after
+		* being pushed.
+		*
+		* @return `true` if no error occurred, `false` otherwise, for example when the
+		* render thread has stopped because of an error.
+		*/
+	bool push_frame_packet(std::shared_ptr<const void> data);
+
+	/**
+		* Get the packet to render in the current frame.
+		*
+		* This method **must** only be called inside the render function, on the render
+		* thread.
+		*
+		* @return The newest packet received by the render thread.
+		*/
+	const FramePacket& get_frame_packet(void) const;
+
+	/**
+		* Choose how the eyes are rendered. Refer to `StereoMode`.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param stereo_mode The stereo mode. Default: `StereoMode::MULTI_PASS`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_stereo_mode(const StereoMode stereo_mode);
+
+	/**
+		* Choose the format of the depth buffers.
+		*
+		* A single depth buffer is shared by all the images of a swapchain (one per eye
+		* when using `MULTI_PASS`, one for both eyes otherwise), since only one image per
+		* swapchain is rendered at a time.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param depth_format The depth format. Default: `DepthFormat::D24`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_depth_format(const DepthFormat depth_format);
+
+	/**
+		* Get the memory saved by sharing a single depth buffer between the images of
+		* each swapchain, compared to one depth buffer per image.
+		*
+		* @return The saved memory in bytes. This is 0 before the session has begun, and
+		* when the depth is submitted (each image then has its own depth image).
+		*/
+	uint64_t get_saved_depth_memory(void) const;
+
+	/**
+		* Submit the depth of each eye to the runtime together with the color.
+		*
+		* This allows the runtime to use depth-aware reprojection, which reduces the
+		* artifacts when a frame is missed. The depth is rendered directly to depth
+		* swapchains created alongside the color swapchains, using the format chosen with
+		* `set_depth_format()` and the clipping planes chosen with `set_clipping_planes()`.
+		*
+		* This requires the `XR_KHR_composition_layer_depth` OpenXR extension. If it is
+		* not available, a warning is printed and the depth is not submitted. If the runtime
+		* does not support the chosen depth format for swapchains, another supported one is
+		* used, and if there is none the depth is not submitted either.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the depth is submitted. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_depth_submission(const bool is_enabled);
+
+	/**
+		* Skip the pixels that are not visible through the lenses of the headset.
+		*
+		* When enabled, XrBridge retrieves the hidden area mesh of each eye from the
+		* runtime and, before calling the render function, clears the depth buffer and
+		* draws the mesh at the near plane. The hidden pixels are then rejected by the
+		* depth test before being shaded. In addition, a scissor rectangle tightly fitting
+		* the visible area is enabled while the render function runs.
+		*
+		* NOTE: When this is enabled, the render function **must not** clear the depth
+		* buffer (clear only the color buffer) and **must** keep the depth test enabled.
+		* The scissor test also applies to `glBlitFramebuffer()`, so disable it before
+		* blitting the image somewhere else.
+		*
+		* This requires the `XR_KHR_visibility_mask` OpenXR extension. If it is
+		* not available, a warning is printed and the mask is not used.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the visibility mask is used. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_visibility_mask(const bool is_enabled);
+
+	/**
+		* Get the fraction of the pixels of an eye that is hidden by the visibility mask
+		* and therefore not shaded.
+		*
+		* @param eye The eye.
+		*
+		* @return A value between 0.0 and 1.0. This is 0.0 if the visibility mask is not
+		* used or if no frame has been rendered yet.
+		*/
+	float get_visibility_mask_culled_ratio(const Eye eye) const;
+
+	/**
+		* Enable the collection of frame timing statistics. Refer to `get_frame_stats()`.
+		*
+		* The GPU time of each eye is measured with `GL_TIME_ELAPSED` queries that are read
+		* back a few frames later, so that the CPU never waits for the GPU. For this reason,
+		* the render function **must not** use `GL_TIME_ELAPSED` queries itself.
+		*
+		* When disabled, no timing is taken and no query is issued.
+		*
+		* The features that adapt to the frame timings (`set_resolution_scaling()`,
+		* `set_just_in_time_start()` and `set_overrun_watchdog()`) read them from these
+		* statistics, so enabling any of them also enables the statistics.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the statistics are collected. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_frame_stats(const bool is_enabled);
+
+	/**
+		* Get the timing statistics of the most recent frames.
+		*
+		* The percentiles are computed over the last `FRAME_STATS_WINDOW_SIZE` frames.
+		* This method is meant to be called once in a while (for example once per second),
+		* not every frame. While the render thread is running, this returns a copy that
+		* the render thread refreshes every few frames.
+		*
+		* @return The statistics. Everything is 0 if the statistics are not enabled.
+		*/
+	FrameStats get_frame_stats(void) const;
+
+	/**
+		* The number of frames used to compute the percentiles of `get_frame_stats()`.
+		*/
+	static const uint32_t FRAME_STATS_WINDOW_SIZE = 256;
+
+	/**
+		* Adapt the rendering resolution to the GPU load.
+		*
+		* When enabled, the swapchains are allocated large enough for `max_scale`, and
+		* only a portion of each image is rendered and submitted each frame. The GPU time
+		* of each frame is compared against the display period: when it is over budget, the
+		* resolution is reduced, and when it is comfortably below budget, the resolution is
+		* increased again.
+		*
+		* The `width` and `height` passed to the render function are the actual size of the
+		* rendered area, and `Fbo::render()` sets the viewports accordingly. The render
+		* function **must not** change the viewports after calling `Fbo::render()`.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the resolution is scaled. Default: `false`
+		* @param min_scale The minimum scale, relative to the resolution recommended by
+		* the runtime. Default: 0.5f
+		* @param max_scale The maximum scale, relative to the resolution recommended by the
+		* runtime. This is limited by the maximum resolution supported by the runtime. Default: 1.0f
+		* @param hysteresis How far below budget the GPU time must be before the resolution
+		* is increased, as a fraction of the budget. This prevents the resolution from
+		* oscillating. Default: 0.1f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_resolution_scaling(const bool is_enabled, const float min_scale = 0.5f, const float max_scale = 1.0f, const float hysteresis = 0.1f);
+
+	/**
+		* Get the current resolution scale, relative to the resolution recommended by the runtime.
+		*
+		* @return The scale. This is 1.0 if the resolution scaling is not enabled.
+		*/
+	float get_resolution_scale(void) const;
+
+	/**
+		* Render the periphery of each eye at a lower resolution (foveated rendering).
+		*
+		* When enabled, the render function is called twice for each eye: first to render
+		* the whole field of view to a smaller FBO, which is then upscaled to the swapchain
+		* image, and then to render a narrow inset at full resolution on top of it. The
+		* second call receives a projection matrix covering only the inset, and the scissor
+		* test is enabled so that `glClear()` only affects the inset. In both cases, `width`
+		* and `height` are the size of the area being rendered and `Fbo::render()` sets the
+		* viewport accordingly.
+		*
+		* The inset is placed at the center of each view, or where the user is looking when
+		* `use_eye_gaze` is `true`. The eye tracking requires the `XR_EXT_eye_gaze_interaction`
+		* OpenXR extension. If it is not available, a warning is printed and the inset stays
+		* at the center.
+		*
+		* This is only supported with `StereoMode::MULTI_PASS`, and cannot be used together
+		* with the resolution scaling or the visibility mask.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether foveated rendering is used. Default: `false`
+		* @param inset_size The size of the full resolution inset, as a fraction of the
+		* width and height of the view. Default: 0.4f
+		* @param peripheral_scale The resolution of the periphery, as a fraction of the
+		* resolution of the view. Default: 0.5f
+		* @param use_eye_gaze Whether the inset follows the gaze of the user. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_foveation(const bool is_enabled, const float inset_size = 0.4f, const float peripheral_scale = 0.5f, const bool use_eye_gaze = false);
+
+	/**
+		* Get where the full resolution inset of an eye was placed in the last frame.
+		*
+		* @param eye The eye of the inset.
+		*
+		* @return The inset, in pixels of the swapchain image. This is empty if the foveation
+		* is not enabled.
+		*/
+	XrRect2Di get_foveation_inset(const Eye eye) const;
+
+	/**
+		* Shade fewer pixels towards the edges of each eye (radial density mask).
+		*
+		* When enabled, XrBridge skips blocks of 2x2 pixels in a checkerboard pattern whose
+		* density falls off with the distance from the center of the lens: inside
+		* `inner_radius` every pixel is shaded, between `inner_radius` and `outer_radius`
+		* half of the blocks are skipped and outside of `outer_radius` three blocks out of four
+		* are skipped. The radii are relative to the field of view of each eye: a radius of 1
+		* reaches the edges of the field of view in each direction.
+		*
+		* Like the visibility mask, the skipped blocks are drawn to the depth buffer at the
+		* near plane before calling the render function, so the same restrictions apply: the
+		* render function **must not** clear the depth buffer and **must** keep the depth test
+		* enabled. Once the render function returns, the skipped pixels are filled in from
+		* their neighbours before the image is submitted.
+		*
+		* This cannot be used together with foveated rendering or with the depth submission.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the density mask is used. Default: `false`
+		* @param inner_radius The radius inside of which every pixel is shaded. Default: 0.5f
+		* @param outer_radius The radius outside of which only a block out of four is shaded. Default: 0.8f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_density_mask(const bool is_enabled, const float inner_radius = 0.5f, const float outer_radius = 0.8f);
+
+	/**
+		* Reuse the previous frame when neither the scene nor the head have moved.
+		*
+		* When enabled, and the scene has been marked as clean with `mark_scene_clean()`,
+		* XrBridge compares the views located for the frame with the ones of the last
+		* rendered frame. If every view is within the given tolerances, the render function
+		* is not called and the last rendered images are submitted again, together with the
+		* poses they were rendered with, so that the runtime reprojects them.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the frames are reused. Default: `false`
+		* @param position_epsilon The maximum distance between the positions of a view,
+		* in meters. Default: 0.001f
+		* @param angle_epsilon The maximum difference between the orientations and the field
+		* of view angles of a view, in radians. Default: 0.001f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_frame_reuse(const bool is_enabled, const float position_epsilon = 0.001f, const float angle_epsilon = 0.001f);
+
+	/**
+		* Tell XrBridge that the scene has not changed since the last rendered frame.
+		*
+		* This only applies to the next frame submitted with `render()`, `render_stereo()`,
+		* `end_frame()` or `end_frame_stereo()`, so it **must** be called again before each
+		* frame that may be reused. Refer to `set_frame_reuse()`.
+		*
+		* This method **must not** be called inside the render function, before this object
+		* has been initialized or after this object has been de-initialized.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool mark_scene_clean(void);
+
+	/**
+		* Get the number of frames that were submitted without calling the render function.
+		*
+		* @return The number of reused frames. This is 0 if the frame reuse is not enabled.
+		*/
+	uint64_t get_reused_frame_count(void) const;
+
+	/**
+		* Update the view matrices right before the frame is submitted (late latching).
+		*
+		* When enabled, the `StereoMatrices` uniform buffer is bound to `STEREO_MATRICES_BINDING`
+		* before calling the render function or the stereo render function. The buffer is
+		* written by the GPU, before the commands of the frame, with a copy of the matrices
+		* published by XrBridge. Once the render function returns, XrBridge locates the views
+		* again and publishes the new view matrices. If the GPU has not made the copy yet, the
+		* frame is rendered and submitted with the new poses, which reduces the latency added
+		* by a slow render function. Otherwise, it is rendered and submitted with the old ones.
+		* Either way, the poses submitted are the ones the GPU has read.
+		*
+		* NOTE: The shaders **must** read the view matrices from the buffer instead of using
+		* the matrices passed to the render function, otherwise the image will be displayed
+		* with the wrong pose. In `MULTI_PASS` mode, use the index of the eye to select
+		* the matrices. The projection matrices are not updated.
+		*
+		* NOTE: To know which poses have been read, XrBridge waits for the GPU to make the copy
+		* before submitting the frame, that is until the GPU has finished the work issued before
+		* the frame. This is why it is off by default: the new poses are only used when the GPU
+		* has not reached the frame yet by the time the render function returns.
+		*
+		* This requires the `GL_ARB_buffer_storage`, `GL_ARB_compute_shader` and
+		* `GL_ARB_shader_storage_buffer_object` OpenGL extensions.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the view matrices are late latched. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_late_latching(const bool is_enabled);
+
+	/**
+		* Limit how many frames the GPU can lag behind the CPU.
+		*
+		* When enabled, XrBridge inserts a fence after the views of each frame and, before
+		* locating the views of a new frame, waits until no more than
+		* `max_frames_in_flight - 1` older frames are still being executed by the GPU. This
+		* keeps the driver from queuing work when the GPU is too slow, so the latency
+		* between the head pose and the display stays bounded. The wait is reported in
+		* `FrameStats::frames_in_flight_wait`.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the frames in flight are limited. Default: `false`
+		* @param max_frames_in_flight The number of frames the GPU can work on at once,
+		* between 1 and `MAX_FRAMES_IN_FLIGHT`. Default: 2
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_frames_in_flight(const bool is_enabled, const uint32_t max_frames_in_flight = 2);
+
+	/**
+		* The maximum value accepted by `set_frames_in_flight()`.
+		*/
+	static const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+	/**
+		* Start rendering each frame as late as possible, so that the head pose is as
+		* recent as possible when the frame is displayed.
+		*
+		* The runtime paces `xrWaitFrame` so that a whole display period is available to
+		* render a frame. When enabled, XrBridge keeps a model of the cost of a frame (the
+		* CPU time from the sampling of the head pose to `xrEndFrame`, plus the GPU time)
+		* and, before sampling the head pose, sleeps until the predicted cost plus a safety
+		* margin is left of that period. The cost follows increases immediately and
+		* decreases slowly. Each time a frame is missed, the margin is doubled, and it then
+		* shrinks by 1% per frame back to `min_margin`.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the frames are started just in time. Default: `false`
+		* @param min_margin The smallest safety margin, in milliseconds. Default: 1.0f
+		* @param max_margin The largest safety margin, in milliseconds. Default: 8.0f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_just_in_time_start(const bool is_enabled, const float min_margin = 1.0f, const float max_margin = 8.0f);
+
+	/**
+		* Degrade the rendering gracefully when the render function is too slow.
+		*
+		* When enabled, the CPU time spent in the render function is compared against the
+		* display period of each frame. After a few consecutive frames over
+		* `overrun_threshold`, the rendering moves one step down the `DegradationLevel`
+		* ladder, skipping the steps that are not available. After many consecutive frames
+		* under `recovery_threshold`, it moves one step back up. Since nothing is measured
+		* while the frames are reused, the watchdog tries to render again after a while.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the watchdog is enabled. Default: `false`
+		* @param max_level The most severe step that can be taken. Default: `DegradationLevel::REUSED_FRAME`
+		* @param overrun_threshold The time above which a frame is overrun, as a fraction of
+		* the display period. Default: 0.8f
+		* @param recovery_threshold The time under which a frame leaves enough headroom to
+		* recover, as a fraction of the display period. Default: 0.5f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_overrun_watchdog(const bool is_enabled, const DegradationLevel max_level = DegradationLevel::REUSED_FRAME, const float overrun_threshold = 0.8f, const float recovery_threshold = 0.5f);
+
+	/**
+		* Get the step currently taken by the overrun watchdog.
+		*
+		* @return The degradation level. This is `DegradationLevel::NONE` if the watchdog
+		* is not enabled.
+		*/
+	DegradationLevel get_degradation_level(void) const;
+
+	/**
+		* Call the OpenXR runtime directly instead of going through the loader.
+		*
+		* When enabled, the pointers of all of the OpenXR functions used by XrBridge are
+		* retrieved once with `xrGetInstanceProcAddr` in `init()`, so that each call skips
+		* the trampoline exported by the OpenXR loader. This is enabled by default; disabling
+		* it is mostly useful to measure the difference.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the runtime is called directly. Default: `true`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_direct_dispatch(const bool is_enabled);
+
+	/**
+		* Poll the OpenXR events on a background thread.
+		*
+		* When enabled, a thread started by `init()` polls the runtime and queues the events
+		* it receives, so `update()` only has to handle the queued events instead of calling
+		* into the runtime. The reactions to the events, such as the creation of the
+		* swapchains when the session begins, still happen inside `update()` on the thread
+		* rendering the frames.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the events are polled on a background thread. Default: `false`
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_event_thread(const bool is_enabled);
+
+	/**
+		* The number of events that can wait in the queue of the event thread.
+		*/
+	static const uint32_t EVENT_QUEUE_SIZE = 32;
+
+	/**
+		* Set a function that is called once per frame, before the first eye is rendered.
+		*
+		* Use this for the work shared by both eyes, such as shadow maps, culling or
+		* simulations, so that it is not repeated for each eye. The function is called after
+		* the views have been located, only for the frames that are actually rendered, with
+		* the same restrictions as the render function. Its CPU time is included in the
+		* `render_function` timing of the frame statistics.
+		*
+		* The function receives the following parameters:
+		* 1. `const XrBridge::StereoMatrices& matrices`: The matrices of both eyes.
+		* 2. `const XrBridge::StereoFrustum& frustum`: A frustum containing both eyes.
+		* 3. `const XrTime predicted_display_time`: The time at which the frame will be displayed.
+		*
+		* The function is stored, so that the frame loop does not allocate any memory.
+		*
+		* This method **must not** be called inside the render function or after this object
+		* has been de-initialized.
+		*
+		* @param pre_pass_function The pre-pass function, or `nullptr` to remove it.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_pre_pass_function(const pre_pass_function_t& pre_pass_function);
+
+	/**
+		* Run background work in the time left after each frame.
+		*
+		* When enabled, the tasks added with `add_slack_task()` are run after `xrEndFrame`,
+		* on the thread rendering the frames, with the OpenGL context current. This is meant
+		* to spread work such as uploading meshes or compiling shaders over many frames
+		* without a second OpenGL context. The runtime leaves a display period between the
+		* end of `xrWaitFrame` and the next one: a new task is only started while more than
+		* `reserve` is left of it, so long tasks **should** be split into steps.
+		*
+		* This method **must** be called before `init()`.
+		*
+		* @param is_enabled Whether the slack tasks are run. Default: `false`
+		* @param reserve The time that is never used by the tasks, in milliseconds, to
+		* absorb the step that overruns. Default: 2.0f
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool set_slack_tasks(const bool is_enabled, const float reserve = 2.0f);
+
+	/**
+		* Queue a task to run in the time left after a frame. Refer to `set_slack_tasks()`.
+		*
+		* The tasks are run in turn: a task that is not finished is resumed after the other
+		* queued tasks have run.
+		*
+		* This method **may** be called inside a slack task, but **must not** be called from
+		* a thread other than the one rendering the frames, before this object has been
+		* initialized or after this object has been de-initialized.
+		*
+		* @param task The task. It **must not** call any method of this object other than
+		* `add_slack_task()`.
+		*
+		* @return `true` if no error occurred, `false` otherwise.
+		*/
+	bool add_slack_task(const slack_task_t& task);
+
+	/**
+		* Sets the far and near clipping planes used to generate the projection matrix.
+		*
+		* @param near_clipping_plane The near clipping plane. Default: 0.1f
+		* @param far_clipping_plane The far clipping plane. Default: 65'536.0f
+		*/
+	void set_clipping_planes(const float near_clipping_plane, const float far_clipping_plane);
+private:
+	/**
+		* The maximum number of views supported. XrBridge only supports HMDs (2 eyes).
+		*/
+	static const uint32_t MAX_VIEWS = 2;
+
+	/**
+		* The maximum number of composition layers submitted each frame.
+		*/
+	static const uint32_t MAX_LAYERS = 1;
+
+	/**
+		* The number of frames the GPU timings are read back after being issued.
+		*/
+	static const uint32_t GPU_TIMER_LATENCY = 4;
+
+	/**
+		* Set in the index of the middle frame packet while the render thread has not read it.
+		*/
+	static const uint32_t FRESH_FRAME_PACKET_BIT = 1u << 31;
+
+	/**
+		* The slots of the late latching staging buffer: the matrices the frame is started with,
+		* and the late latched ones. The slots follow the index of the published one.
+		*/
+	static const uint32_t LATE_LATCHING_ORIGINAL_SLOT = 0;
+	static const uint32_t LATE_LATCHING_LATCHED_SLOT = 1;
+	static const GLsizeiptr LATE_LATCHING_SLOT_OFFSET = 16;
+	static const GLsizeiptr LATE_LATCHING_STAGING_SIZE = LATE_LATCHING_SLOT_OFFSET + 2 * sizeof(StereoMatrices);
+
+	// The timings collected in the frame statistics.
+	enum class Timing { WAIT_FRAME, BEGIN_FRAME, ACQUIRE_IMAGE, WAIT_IMAGE, WAIT_IMAGE_LEFT, WAIT_IMAGE_RIGHT, RENDER_FUNCTION, END_FRAME, GPU_LEFT, GPU_RIGHT, POSE_TO_END_FRAME, FRAMES_IN_FLIGHT_WAIT, FRAME_PACKET_AGE, JUST_IN_TIME_SLEEP, SLACK_TASKS, COUNT };
+
+	// The last samples of a single timing, in milliseconds.
+	struct TimingWindow
+	{
+		/**
+			* A ring buffer of samples.
+			*/
+		std::array<float, FRAME_STATS_WINDOW_SIZE> samples;
+
+		/**
+			* The number of valid samples.
+			*/
+		uint32_t sample_count;
+
+		/**
+			* The index where the next sample will be written.
+			*/
+		uint32_t next_sample;
+	};
+
+	// Everything needed to collect the frame statistics.
+	struct FrameStatsState
+	{
+		/**
+			* The samples of each timing.
+			*/
+		std::array<TimingWindow, static_cast<size_t>(Timing::COUNT)> windows;
+
+		/**
+			* The CPU timings of the frame being submitted, accumulated over all of the views.
+			*/
+		std::array<float, static_cast<size_t>(Timing::COUNT)> frame_timings;
+
+		/**
+			* When the views of the frame being submitted were located.
+			*/
+		std::chrono::steady_clock::time_point pose_time;
+
+		/**
+			* The predicted display time of the previous frame.
+			*/
+		XrTime last_display_time;
+
+		uint64_t frame_count;
+		uint64_t missed_frame_count;
+		uint64_t wait_image_timeout_count;
+
+		/**
+			* A ring of `GL_TIME_ELAPSED` queries, one per view and per frame in flight.
+			*/
+		std::array<std::array<GLuint, MAX_VIEWS>, GPU_TIMER_LATENCY> gpu_queries;
+
+		/**
+			* Whether each query has been issued and not yet read back.
+			*/
+		std::array<std::array<bool, MAX_VIEWS>, GPU_TIMER_LATENCY> is_gpu_query_pending;
+
+		/**
+			* The index of the ring entry used by the frame being submitted.
+			*/
+		uint32_t gpu_query_frame;
+	};
+
+	// The state of the dynamic resolution scaling.
+	struct ResolutionScaling
+	{
+		/**
+			* The settings passed to `set_resolution_scaling()`.
+			*/
+		float min_scale = 0.5f;
+		float max_scale = 1.0f;
+		float hysteresis = 0.1f;
+
+		/**
+			* The current scale.
+			*/
+		float scale = 1.0f;
+
+		/**
+			* Whether the image rectangles and the viewports need to be updated to the current scale.
+			*/
+		bool is_dirty = false;
+
+		/**
+			* The number of GPU timings to ignore, since they were measured before the last change.
+			*/
+		uint32_t ignored_timing_count = 0;
+
+		/**
+			* The display period of the last frame, in milliseconds.
+			*/
+		float display_period = 0.0f;
+
+		/**
+			* The size of each view recommended by the runtime.
+			*/
+		std::array<XrExtent2Di, MAX_VIEWS> recommended_extents = {};
+	};
+
+	// This is used to easily tie together swapchains with their framebuffer IDs and sizes.
+	struct Swapchain
+	{
+		/**
+			* The OpenXR swapchain.
+			*/
+		XrSwapchain swapchain;
+
+		/**
+			* All of the FBOs assigned to this swapchain.
+			*
+			* In the case of double-buffering, the framebuffers will be 2. In case of
+			* triple-buffering, the framebuffers will be 3.
+			*/
+		std::vector<std::shared_ptr<Fbo>> framebuffers;
+
+		/**
+			* The width in pixels of the images.
+			*/
+		uint32_t width;
+
+		/**
+			* The height in pixels of the images.
+			*/
+		uint32_t height;
+
+		/**
+			* The number of views rendered to this swapchain. This is 1 when using `MULTI_PASS`, 2 otherwise.
+			*/
+		uint32_t view_count;
+
+		/**
+			* The region of the images assigned to each view. When using `INSTANCED`, the views are
+			* placed side by side. Otherwise, each view covers the whole image (or array layer).
+			* When the resolution is scaled, only a part of each region is rendered.
+			*/
+		std::array<XrRect2Di, MAX_VIEWS> view_rects;
+
+		/**
+			* The number of array layers of each image. This is 2 when using `MULTIVIEW`, 1 otherwise.
+			*/
+		uint32_t array_size;
+
+		/**
+			* The depth texture shared by all of the FBOs of this swapchain. This is 0 when
+			* the depth is submitted to the runtime.
+			*/
+		GLuint depth_texture;
+
+		/**
+			* The depth swapchain, when the depth is submitted to the runtime.
+			*/
+		XrSwapchain depth_swapchain;
+
+		/**
+			* The images of the depth swapchain.
+			*/
+		std::vector<GLuint> depth_images;
+
+		/**
+			* The color images of the swapchain.
+			*/
+		std::vector<GLuint> color_images;
+	};
+
+	// Everything needed for foveated rendering.
+	struct Foveation
+	{
+		/**
+			* The settings passed to `set_foveation()`.
+			*/
+		float inset_size = 0.4f;
+		float peripheral_scale = 0.5f;
+		bool is_eye_gaze_enabled = false;
+
+		/**
+			* The low resolution render targets of the periphery, one per view. They are not
+			* OpenXR swapchains: only the FBO, the sizes and the depth texture are used.
+			*/
+		std::vector<Swapchain> peripheral_buffers = {};
+
+		/**
+			* The color textures of `peripheral_buffers`.
+			*/
+		std::array<GLuint, MAX_VIEWS> peripheral_color_textures = {};
+
+		/**
+			* The region of each view rendered at full resolution, in pixels.
+			*/
+		std::array<XrRect2Di, MAX_VIEWS> inset_rects = {};
+
+		/**
+			* The projection matrices covering only the insets.
+			*/
+		std::array<glm::mat4, MAX_VIEWS> inset_projection_matrices = {};
+
+		/**
+			* The action used to track the gaze of the user.
+			*/
+		XrActionSet action_set = XR_NULL_HANDLE;
+		XrAction gaze_action = XR_NULL_HANDLE;
+		XrSpace gaze_space = XR_NULL_HANDLE;
+	};
+
+	// Everything needed for the radial density mask.
+	struct DensityMask
+	{
 		/**
-			* The height in pixels of the view.
+			* The settings passed to `set_density_mask()`.
 			*/
-		uint32_t height;
+		float inner_radius = 0.5f;
+		float outer_radius = 0.8f;
+
+		/**
+			* The shader drawing the skipped blocks to the depth buffer.
+			*/
+		GLuint mask_shader = 0;
+
+		/**
+			* The shader filling in the skipped pixels.
+			*/
+		GLuint reconstruction_shader = 0;
+
+		/**
+			* An empty vertex array, since both shaders generate their vertices.
+			*/
+		GLuint vao = 0;
+
+		/**
+			* A copy of the rendered image of each swapchain, read by the reconstruction.
+			*/
+		std::vector<GLuint> scratch_textures = {};
+	};
+
+	// The state of the static frame reuse.
+	struct FrameReuse
+	{
+		/**
+			* The settings passed to `set_frame_reuse()`.
+			*/
+		float position_epsilon = 0.001f;
+		float angle_epsilon = 0.001f;
+
+		/**
+			* Whether the scene has been marked as clean for the next frame.
+			*/
+		bool is_scene_clean = false;
+
+		/**
+			* Whether the swapchains hold a rendered frame that can be submitted again.
+			*/
+		bool has_rendered_frame = false;
+
+		/**
+			* The views the last rendered frame was rendered with.
+			*/
+		std::array<XrView, MAX_VIEWS> rendered_views = {};
+
+		uint64_t reused_frame_count = 0;
+	};
+
+	// The state of the late latching.
+	struct LateLatching
+	{
+		/**
+			* The buffer written by the CPU: the index of the published slot, followed by the slots.
+			*/
+		GLuint staging_buffer = 0;
+
+		/**
+			* The persistent mapping of `staging_buffer`. The slots are only written once the copy
+			* of the previous frame has completed, so they never change while the GPU reads them.
+			*/
+		uint8_t* mapped_staging_buffer = nullptr;
+
+		/**
+			* The buffer written by the GPU: the index of the slot copied to the matrices buffer.
+			*/
+		GLuint copied_slot_buffer = 0;
+
+		/**
+			* The persistent mapping of `copied_slot_buffer`.
+			*/
+		const uint32_t* mapped_copied_slot_buffer = nullptr;
+
+		/**
+			* The compute shader that copies the published slot to the matrices buffer.
+			*/
+		GLuint copy_shader = 0;
+
+		/**
+			* Signaled when the GPU has copied the matrices of the frame being submitted, which
+			* happens before any command issued for the frame by the render function.
+			*/
+		GLsync copy_fence = nullptr;
+	};
+
+	// The state of the frames in flight limit.
+	struct FramesInFlight
+	{
+		/**
+			* The setting passed to `set_frames_in_flight()`.
+			*/
+		uint32_t max_frames_in_flight = 2;
+
+		/**
+			* A ring of fences, one per frame in flight, signaled when the GPU has finished the frame.
+			*/
+		std::array<GLsync, MAX_FRAMES_IN_FLIGHT> fences = {};
+
+		/**
+			* The index of the ring entry used by the frame being submitted.
+			*/
+		uint32_t next_fence = 0;
+	};
+
+	// The state of the just-in-time start.
+	struct JustInTime
+	{
+		/**
+			* The settings passed to `set_just_in_time_start()`.
+			*/
+		float min_margin = 1.0f;
+		float max_margin = 8.0f;
+
+		/**
+			* The current safety margin, in milliseconds.
+			*/
+		float margin = 1.0f;
+
+		/**
+			* The predicted CPU and GPU costs of a frame, in milliseconds.
+			*/
+		float cpu_cost = 0.0f;
+		float gpu_cost = 0.0f;
+
+		/**
+			* When the frame being submitted was started, after the sleep.
+			*/
+		std::chrono::steady_clock::time_point frame_start = {};
+
+		/**
+			* The number of missed frames when the margin was last updated.
+			*/
+		uint64_t missed_frame_count = 0;
+	};
+
+	// The state of the overrun watchdog.
+	struct Watchdog
+	{
+		/**
+			* The settings passed to `set_overrun_watchdog()`.
+			*/
+		DegradationLevel max_level = DegradationLevel::REUSED_FRAME;
+		float overrun_threshold = 0.8f;
+		float recovery_threshold = 0.5f;
+
+		DegradationLevel level = DegradationLevel::NONE;
+
+		/**
+			* The number of consecutive frames over the overrun threshold and under the
+			* recovery threshold.
+			*/
+		uint32_t overrun_frame_count = 0;
+		uint32_t headroom_frame_count = 0;
+
+		uint64_t overrun_count = 0;
+	};
+
+	// The events handled by `update()`, decoded from the OpenXR events.
+	enum class EventType { EVENTS_LOST, INSTANCE_LOSS_PENDING, VISIBILITY_MASK_CHANGED, SESSION_STATE_CHANGED };
+
+	struct Event
+	{
+		EventType type;
+
+		/**
+			* The session the event refers to, if any.
+			*/
+		XrSession session;
+
+		/**
+			* The new state of the session, for `SESSION_STATE_CHANGED`.
+			*/
+		XrSessionState session_state;
+
+		/**
+			* The view whose visibility mask changed, for `VISIBILITY_MASK_CHANGED`.
+			*/
+		uint32_t view_index;
+	};
+
+	// The state of the event thread. Refer to `set_event_thread()`.
+	struct EventThread
+	{
+		/**
+			* A ring of events, written only by the event thread and read only by `update()`.
+			*/
+		std::array<Event, EVENT_QUEUE_SIZE> events;
+
+		/**
+			* The number of events pushed and popped since the thread was started. Each one
+			* is only written by one of the two threads.
+			*/
+		std::atomic<uint64_t> push_count;
+		std::atomic<uint64_t> pop_count;
+
+		std::thread thread;
+		std::atomic<bool> should_stop;
+
+		/**
+			* Set by the event thread when polling fails, after which it exits.
+			*/
+		std::atomic<bool> has_failed;
+	};
+
+	// The state of the render thread. Refer to `start_render_thread()`.
+	struct RenderThread
+	{
+		/**
+			* Three packets exchanged without locks. The application thread writes the back
+			* one, the render thread reads the front one, and the middle one holds the newest
+			* packet pushed. Each thread swaps its own packet with the middle one.
+			*/
+		std::array<FramePacket, 3> packets;
+		uint32_t back_packet;
+		uint32_t front_packet;
+
+		/**
+			* The index of the middle packet, with `FRESH_FRAME_PACKET_BIT` set until the render
+			* thread has read it.
+			*/
+		std::atomic<uint32_t> middle_packet;
+
+		/**
+			* The number of packets pushed since the thread was started, written by the
+			* application thread, and the value it had when the render thread last read it.
+			*/
+		std::atomic<uint64_t> push_count;
+		uint64_t pop_count;
+
+		std::atomic<uint64_t> dropped_packet_count;
+
+		/**
+			* The newest packet read by the render thread, and the number of packets pushed
+			* since the previous one was read. Only used by the render thread.
+			*/
+		FramePacket packet;
+		uint32_t queue_depth;
+
+		std::thread thread;
+		std::atomic<bool> should_stop;
+
+		/**
+			* Cleared by the render thread when it exits, after setting `has_failed`.
+			*/
+		std::atomic<bool> is_running;
+		bool has_failed;
+
+		/**
+			* Make the OpenGL context of the application current (or not current) on the
+			* calling thread.
+			*/
+		std::function<bool(const bool is_current)> make_context_current;
+
+		/**
+			* A copy of the statistics for the other threads, refreshed by the render thread.
+			*/
+		mutable std::mutex stats_mutex;
+		FrameStats stats;
+	};
+
+	// The OpenXR functions used after the instance is created. Refer to `set_direct_dispatch()`.
+	struct DispatchTable
+	{
+		PFN_xrAcquireSwapchainImage xrAcquireSwapchainImage;
+		PFN_xrAttachSessionActionSets xrAttachSessionActionSets;
+		PFN_xrBeginFrame xrBeginFrame;
+		PFN_xrBeginSession xrBeginSession;
+		PFN_xrCreateAction xrCreateAction;
+		PFN_xrCreateActionSet xrCreateActionSet;
+		PFN_xrCreateActionSpace xrCreateActionSpace;
+		PFN_xrCreateReferenceSpace xrCreateReferenceSpace;
+		PFN_xrCreateSession xrCreateSession;
+		PFN_xrCreateSwapchain xrCreateSwapchain;
+		PFN_xrDestroyActionSet xrDestroyActionSet;
+		PFN_xrDestroyInstance xrDestroyInstance;
+		PFN_xrDestroySession xrDestroySession;
+		PFN_xrDestroySpace xrDestroySpace;
+		PFN_xrDestroySwapchain xrDestroySwapchain;
+		PFN_xrEndFrame xrEndFrame;
+		PFN_xrEndSession xrEndSession;
+		PFN_xrEnumerateSwapchainFormats xrEnumerateSwapchainFormats;
+		PFN_xrEnumerateSwapchainImages xrEnumerateSwapchainImages;
+		PFN_xrEnumerateViewConfigurationViews xrEnumerateViewConfigurationViews;
+		PFN_xrGetInstanceProperties xrGetInstanceProperties;
+		PFN_xrGetSystem xrGetSystem;
+		PFN_xrGetSystemProperties xrGetSystemProperties;
+		PFN_xrLocateSpace xrLocateSpace;
+		PFN_xrLocateViews xrLocateViews;
+		PFN_xrPollEvent xrPollEvent;
+		PFN_xrReleaseSwapchainImage xrReleaseSwapchainImage;
+		PFN_xrStringToPath xrStringToPath;
+		PFN_xrSuggestInteractionProfileBindings xrSuggestInteractionProfileBindings;
+		PFN_xrSyncActions xrSyncActions;
+		PFN_xrWaitFrame xrWaitFrame;
+		PFN_xrWaitSwapchainImage xrWaitSwapchainImage;
+
+		// The optional extension functions, `nullptr` when the extension is not enabled.
+		PFN_xrGetVisibilityMaskKHR xrGetVisibilityMaskKHR;
+	};
+
+	// The visibility mask of a single view, in view space (on the z = -1 plane).
+	struct VisibilityMask
+	{
+		/**
+			* The triangles covering the area hidden by the lenses.
+			*/
+		std::vector<XrVector2f> hidden_triangles;
+
+		/**
+			* The bounding box of the visible area.
+			*/
+		XrVector2f visible_min;
+		XrVector2f visible_max;
+
+		/**
+			* The fraction of the view hidden by the mask. This is computed as soon as the
+			* field of view of the view is known.
+			*/
+		float culled_ratio;
+
+		/**
+			* Whether `culled_ratio` needs to be computed.
+			*/
+		bool is_culled_ratio_dirty;
+
+		/**
+			* The range of vertices of this view inside the vertex buffer of the masks.
+			*/
+		GLint first_vertex;
+		GLsizei vertex_count;
+	};
+
+	// All of the storage needed to build and submit a frame. This is set up once in
+	// `begin_session()` so that the frame loop does not need to allocate any memory.
+	struct FrameState
+	{
+		/**
+			* The number of views, cached from the view configuration.
+			*/
+		uint32_t view_count;
+
+		/**
+			* The views located each frame.
+			*/
+		std::array<XrView, MAX_VIEWS> views;
+
+		/**
+			* The projection views submitted each frame. Only the pose and fov change between frames.
+			*/
+		std::array<XrCompositionLayerProjectionView, MAX_VIEWS> projection_views;
+
+		/**
+			* The depth of each projection view, when the depth is submitted to the runtime.
+			*/
+		std::array<XrCompositionLayerDepthInfoKHR, MAX_VIEWS> depth_infos;
+
+		/**
+			* The projection layer pointing to `projection_views`.
+			*/
+		XrCompositionLayerProjection projection_layer;
+
+		/**
+			* The layers submitted to `xrEndFrame`.
+			*/
+		std::array<const XrCompositionLayerBaseHeader*, MAX_LAYERS> layers;
+
+		/**
+			* The matrices of the located views.
+			*/
+		StereoMatrices matrices;
+
+		/**
+			* The scissor rectangles fitting the visible area of each view, when using the visibility mask.
+			*/
+		std::array<XrRect2Di, MAX_VIEWS> scissor_rects;
+
+		/**
+			* The frustum containing the located views, when a pre-pass function is set.
+			*/
+		StereoFrustum frustum;
+
+		/**
+			* The inverses of the view matrices.
+			*/
+		std::array<glm::mat4, MAX_VIEWS> inverse_view_matrices;
+
+		/**
+			* The image acquired from each swapchain for the frame being submitted.
+			*/
+		std::array<uint32_t, MAX_VIEWS> image_indices;
+
+		/**
+			* Whether the projection layer is submitted with the frame being submitted.
+			*/
+		bool has_projection_layer;
+
+		/**
+			* Whether the views of the frame being submitted are rendered, rather than reused.
+			*/
+		bool is_rendering_views;
+
+		/**
+			* Whether only the LEFT eye is rendered, and submitted for both eyes. Refer to
+			* `DegradationLevel::SINGLE_EYE`.
+			*/
+		bool is_single_eye;
 	};
 
+	bool load_dispatch_table(void);
+
+	FrameStats compute_frame_stats(void) const;
+
+	bool poll_event(Event& event, bool& has_event);
+	bool handle_event(const Event& event);
+	void run_event_thread(void);
+
+	bool launch_render_thread(const render_function_t& render_function, const stereo_render_function_t& stereo_render_function);
+	void run_render_thread(const render_function_t& render_function, const stereo_render_function_t& stereo_render_function);
+	bool is_used_by_render_thread(void) const;
+	void pop_frame_packets(void);
+
 	bool begin_session(void);
+	bool select_depth_swapchain_format(void);
 	bool end_session(void);
 
-	std::shared_ptr<Fbo> create_fbo(const GLuint color, const GLsizei width, const GLsizei height) const;
+	// Run the checks shared by the `render()` overloads, then wait and begin the frame.
+	//  `is_frame_begun` is left false when the session is not running, in which case nothing is rendered.
+	bool begin_render(FrameToken& frame, bool& is_frame_begun);
+
+	bool submit_frame(FrameToken& frame, const render_function_t* render_function, const stereo_render_function_t* stereo_render_function);
+	bool prepare_frame(FrameToken& frame, const bool is_multi_pass);
+	bool finish_frame(FrameToken& frame);
+	bool locate_views(const FrameToken& frame);
+	void compute_stereo_frustum(void);
+	bool wait_frames_in_flight(void);
+
+	void sleep_until_just_in_time(const FrameToken& frame);
+	void run_slack_tasks(const FrameToken& frame);
+	void update_just_in_time(void);
+
+	bool is_degradation_level_available(const DegradationLevel level) const;
+	void update_watchdog(const FrameToken& frame);
+	void set_degradation_level(const DegradationLevel level);
+	void share_left_eye(void);
+	bool write_late_latched_matrices(void);
+	bool wait_late_latching_copy(void);
+	void bind_late_latched_matrices(void) const;
+	bool late_latch_views(const FrameToken& frame);
+	bool render_multi_pass(const render_function_t& render_function);
+	bool render_single_pass(const stereo_render_function_t& stereo_render_function);
+	bool begin_view(const uint32_t view_index, uint32_t& image_index);
+	void end_view(const uint32_t view_index, const uint32_t image_index);
+
+	bool fetch_visibility_mask(const uint32_t view_index);
+	bool upload_visibility_masks(void);
+	void prime_depth(const std::shared_ptr<Fbo>& fbo, const uint32_t first_view, const uint32_t view_count) const;
+	void enable_visibility_mask_scissor(const uint32_t first_view, const uint32_t view_count) const;
+
+	void record_timing(const Timing timing, const float milliseconds);
+	void add_frame_timing(const Timing timing, const std::chrono::steady_clock::time_point start);
+	void begin_gpu_timer(const uint32_t view_index);
+	void end_gpu_timer(void);
+	void collect_gpu_timers(void);
+
+	void update_resolution_scale(const float gpu_time);
+	void apply_resolution_scale(void);
+
+	bool can_reuse_frame(void) const;
+
+	void set_density_mask_uniforms(const uint32_t first_view, const uint32_t view_count) const;
+	void reconstruct_density_mask(const Swapchain& swapchain, const uint32_t image_index, const std::shared_ptr<Fbo>& fbo, const uint32_t first_view, const uint32_t view_count) const;
+
+	bool create_eye_gaze_action(void);
+	bool update_foveation(const FrameToken& frame);
+	void render_foveated_view(const render_function_t& render_function, const uint32_t view_index, const std::shared_ptr<Fbo>& fbo);
+
+	bool acquire_swapchain_images(const Swapchain& swapchain, uint32_t& image_index);
+	bool wait_swapchain_images(const Swapchain& swapchain, const uint32_t view_index);
+	bool wait_swapchain_image(const XrSwapchain swapchain);
+	bool release_swapchain_images(const Swapchain& swapchain) const;
+
+	GLuint create_depth_texture(const Swapchain& swapchain) const;
+	std::shared_ptr<Fbo> create_fbo(const GLuint color, const GLuint depth, const Swapchain& swapchain) const;
 
 	// This prevents the user from calling other methods on this object inside
 	// the user-provide render function (`render_function` parameter of the `render`)
@@ -192,10 +2015,149 @@ private:
 	float near_clipping_plane;
 	float far_clipping_plane;
 
+	StereoMode stereo_mode;
+	DepthFormat depth_format;
+	uint64_t saved_depth_memory;
+	bool is_depth_submission_enabled;
+
+	bool is_visibility_mask_enabled;
+	std::array<VisibilityMask, MAX_VIEWS> visibility_masks;
+	GLuint visibility_mask_shader;
+	GLuint visibility_mask_vao;
+	GLuint visibility_mask_vbo;
+
+	bool is_frame_stats_enabled;
+	FrameStatsState frame_stats;
+
+	bool is_resolution_scaling_enabled;
+	ResolutionScaling resolution_scaling;
+
+	bool is_foveation_enabled;
+	Foveation foveation;
+
+	bool is_density_mask_enabled;
+	DensityMask density_mask;
+
+	bool is_frame_reuse_enabled;
+	FrameReuse frame_reuse;
+
+	bool is_late_latching_enabled;
+	LateLatching late_latching;
+
+	bool is_frames_in_flight_enabled;
+	FramesInFlight frames_in_flight;
+
+	bool is_just_in_time_enabled;
+	JustInTime just_in_time;
+
+	bool is_watchdog_enabled;
+	Watchdog watchdog;
+
+	bool is_slack_tasks_enabled;
+	// The time that is never used by the slack tasks, in milliseconds.
+	float slack_reserve;
+	std::deque<slack_task_t> slack_tasks;
+
+	bool is_direct_dispatch_enabled;
+	DispatchTable dispatch;
+
+	bool is_render_thread_enabled;
+	RenderThread render_thread;
+
+	bool is_event_thread_enabled;
+	EventThread event_thread;
+
+	pre_pass_function_t pre_pass_function;
+
+	GLuint stereo_matrices_buffer;
+
 	XrInstance instance;
 	XrSystemId system_id;
 	XrSession session;
 	XrSessionState session_state;
+	// Whether the session has been begun and not ended yet, so that frames can be submitted.
+	bool is_session_running_flag;
 	std::vector<Swapchain> swapchains;
 	XrSpace space;
+	FrameState frame_state;
 };
+
+template <typename F, typename>
+bool XrBridge::render(F&& render_function)
+{
+	FrameToken frame = {};
+	bool is_frame_begun = false;
+
+	if (this->begin_render(frame, is_frame_begun) == false)
+	{
+		return false;
+	}
+
+	if (is_frame_begun == false)
+	{
+		return true;
+	}
+
+	return this->end_frame(frame, std::forward<F>(render_function));
+}
+
+template <typename F, typename>
+bool XrBridge::end_frame(FrameToken& frame, F&& render_function)
+{
+	if (this->prepare_frame(frame, true) == false)
+	{
+		return false;
+	}
+
+	const FrameState& frame_state = this->frame_state;
+
+	// In single-eye mode only the left swapchain has been acquired.
+	const uint32_t view_count = frame_state.is_single_eye ? 1 : frame_state.view_count;
+	for (uint32_t view_index = 0; frame_state.is_rendering_views && view_index < view_count; ++view_index)
+	{
+		uint32_t image_index = 0;
+		if (this->begin_view(view_index, image_index) == false)
+		{
+			return false;
+		}
+
+		const std::shared_ptr<Fbo>& fbo = this->swapchains[view_index].framebuffers[image_index];
+
+		const std::chrono::steady_clock::time_point render_function_start = this->is_frame_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+		if (this->is_foveation_enabled)
+		{
+			// The foveated passes use their own matrices and FBOs, so they go through the
+			//  `std::function` path. The lambda only captures a reference, so it is not allocated.
+			const render_function_t foveated_render_function = [&render_function] (const Eye eye, const std::shared_ptr<Fbo>& fbo, const glm::mat4 projection_matrix, const glm::mat4 view_matrix, const uint32_t width, const uint32_t height) {
+				const glm::mat4 inverse_view_matrix = glm::inverse(view_matrix);
+				const glm::mat4 view_projection_matrix = projection_matrix * inverse_view_matrix;
+				render_function(View{ eye, *fbo, projection_matrix, view_matrix, view_projection_matrix, inverse_view_matrix, width, height });
+			};
+
+			this->render_foveated_view(foveated_render_function, view_index, fbo);
+		}
+		else
+		{
+			const XrExtent2Di& extent = frame_state.projection_views[view_index].subImage.imageRect.extent;
+
+			render_function(View{
+				view_index == 0 ? Eye::LEFT : Eye::RIGHT,
+				*fbo,
+				frame_state.matrices.projection_matrices[view_index],
+				frame_state.matrices.view_matrices[view_index],
+				frame_state.matrices.view_projection_matrices[view_index],
+				frame_state.inverse_view_matrices[view_index],
+				static_cast<uint32_t>(extent.width),
+				static_cast<uint32_t>(extent.height) });
+		}
+
+		if (this->is_frame_stats_enabled)
+		{
+			this->add_frame_timing(Timing::RENDER_FUNCTION, render_function_start);
+		}
+
+		this->end_view(view_index, image_index);
+	}
+
+	return this->finish_frame(frame);
+}